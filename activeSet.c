@@ -0,0 +1,121 @@
+#include "activeSet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool initActiveSet(ActiveSet* set, int initialCapacity, AdmissionPolicy policy) {
+    if (initialCapacity <= 0) initialCapacity = ACTIVE_SET_INITIAL_CAPACITY;
+
+    set->vehicles = (VehicleUI*)malloc(sizeof(VehicleUI) * initialCapacity);
+    if (set->vehicles == NULL) {
+        printf("Memory allocation failed for active vehicle set\n");
+        set->count = 0;
+        set->capacity = 0;
+        return false;
+    }
+    set->count = 0;
+    set->capacity = initialCapacity;
+    set->policy = policy;
+    return true;
+}
+
+void freeActiveSet(ActiveSet* set) {
+    free(set->vehicles);
+    set->vehicles = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
+
+bool activeSetCanAdmit(const ActiveSet* set) {
+    return set->policy.maxActive <= 0 || set->count < set->policy.maxActive;
+}
+
+// Grows the storage so `count` vehicles fit; false if memory ran out
+bool activeSetReserve(ActiveSet* set, int count) {
+    if (count <= set->capacity) return true;
+    int newCapacity = set->capacity > 0 ? set->capacity * 2 : ACTIVE_SET_INITIAL_CAPACITY;
+    while (newCapacity < count) newCapacity *= 2;
+    VehicleUI* grown = (VehicleUI*)realloc(set->vehicles, sizeof(VehicleUI) * newCapacity);
+    if (grown == NULL) {
+        printf("Error: could not grow active vehicle set to %d\n", newCapacity);
+        return false;
+    }
+    set->vehicles = grown;
+    set->capacity = newCapacity;
+    return true;
+}
+
+// Returns a slot for a new vehicle, growing the storage when it is full.
+// The caller must fill in every field of the returned slot.
+VehicleUI* activeSetAdd(ActiveSet* set) {
+    if (!activeSetReserve(set, set->count + 1)) return NULL;
+    return &set->vehicles[set->count++];
+}
+
+// Removes the vehicle at index by moving the last vehicle into its place.
+// Order is not preserved, so callers iterating forward must revisit index.
+void activeSetRemove(ActiveSet* set, int index) {
+    if (index < 0 || index >= set->count) return;
+    set->count--;
+    if (index != set->count) {
+        set->vehicles[index] = set->vehicles[set->count];
+    }
+}
+
+void initArrivalStaging(ArrivalStaging* staging) {
+    pthread_mutex_init(&staging->lock, NULL);
+    staging->pending = NULL;
+    staging->count = 0;
+    staging->capacity = 0;
+}
+
+void freeArrivalStaging(ArrivalStaging* staging) {
+    free(staging->pending);
+    staging->pending = NULL;
+    staging->count = 0;
+    staging->capacity = 0;
+    pthread_mutex_destroy(&staging->lock);
+}
+
+bool stageArrival(ArrivalStaging* staging, Vehicle vehicle) {
+    return stageArrivals(staging, &vehicle, 1);
+}
+
+// Stages a run of vehicles under one lock, so a bulk producer pays for the
+// lock once per batch rather than once per vehicle
+bool stageArrivals(ArrivalStaging* staging, const Vehicle* vehicles, int count) {
+    pthread_mutex_lock(&staging->lock);
+    if (staging->count + count > staging->capacity) {
+        int newCapacity = staging->capacity > 0 ? staging->capacity * 2 : 64;
+        while (newCapacity < staging->count + count) newCapacity *= 2;
+        Vehicle* grown = (Vehicle*)realloc(staging->pending, sizeof(Vehicle) * newCapacity);
+        if (grown == NULL) {
+            pthread_mutex_unlock(&staging->lock);
+            printf("Error: could not stage vehicle %s\n", vehicles[0].VechicleName);
+            return false;
+        }
+        staging->pending = grown;
+        staging->capacity = newCapacity;
+    }
+    memcpy(&staging->pending[staging->count], vehicles, sizeof(Vehicle) * count);
+    staging->count += count;
+    pthread_mutex_unlock(&staging->lock);
+    return true;
+}
+
+// Hands the pending arrivals to the caller and takes the caller's spare
+// buffer in exchange, so producers never wait on the merge itself.
+// Returns the number of vehicles now in *buffer.
+int swapStagedArrivals(ArrivalStaging* staging, Vehicle** buffer, int* capacity) {
+    pthread_mutex_lock(&staging->lock);
+    int count = staging->count;
+    Vehicle* spare = *buffer;
+    int spareCapacity = *capacity;
+    *buffer = staging->pending;
+    *capacity = staging->capacity;
+    staging->pending = spare;
+    staging->capacity = spareCapacity;
+    staging->count = 0;
+    pthread_mutex_unlock(&staging->lock);
+    return count;
+}
@@ -0,0 +1,64 @@
+#ifndef ACTIVESET_H
+#define ACTIVESET_H
+#include <stdbool.h>
+#include <pthread.h>
+#include "dataManagement.h"
+
+#define ACTIVE_SET_INITIAL_CAPACITY 256
+
+// Vehicle currently travelling through the junction
+typedef struct {
+    Vehicle vehicle;
+    float x, y;           // Precise position for smooth movement
+    float prevX, prevY;   // Position at the start of the current tick
+    float distance;       // World units travelled along the route
+    int fixedDistance;    // The same in fixed-point units, used by the fixed-point mode
+    int route;            // Index into the junction's route table
+    bool isMoving;
+    bool hasArrived;
+} VehicleUI;
+
+// Admission policy: how many vehicles may be in flight at once.
+// A value of 0 means "no limit".
+typedef struct {
+    int maxActive;          // Cap on vehicles inside the junction
+    int maxReleasePerTick;  // Cap on vehicles released from queues per tick
+} AdmissionPolicy;
+
+// Dynamically sized set of in-flight vehicles.
+// Insert appends at the end, remove swaps the last element into the hole,
+// so both are O(1) and the storage stays dense for the update loop.
+typedef struct {
+    VehicleUI* vehicles;
+    int count;
+    int capacity;
+    AdmissionPolicy policy;
+} ActiveSet;
+
+// Arrivals produced by other threads. The simulation thread swaps the
+// pending buffer out at the start of a tick and merges it into the set,
+// so the set itself only ever has one writer. The junction keeps one per
+// road, so producers feeding different roads never share a lock, and each
+// keeps its vehicles in the order they were staged. Each starts on its own
+// cache line, so neighbouring shards in an array do not false-share.
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) pthread_mutex_t lock;
+    Vehicle* pending;
+    int count;
+    int capacity;
+} ArrivalStaging;
+
+bool initActiveSet(ActiveSet* set, int initialCapacity, AdmissionPolicy policy);
+void freeActiveSet(ActiveSet* set);
+bool activeSetCanAdmit(const ActiveSet* set);
+bool activeSetReserve(ActiveSet* set, int count);
+VehicleUI* activeSetAdd(ActiveSet* set);
+void activeSetRemove(ActiveSet* set, int index);
+
+void initArrivalStaging(ArrivalStaging* staging);
+void freeArrivalStaging(ArrivalStaging* staging);
+bool stageArrival(ArrivalStaging* staging, Vehicle vehicle);
+bool stageArrivals(ArrivalStaging* staging, const Vehicle* vehicles, int count);
+int swapStagedArrivals(ArrivalStaging* staging, Vehicle** buffer, int* capacity);
+
+#endif
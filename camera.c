@@ -0,0 +1,88 @@
+#include "camera.h"
+
+// Whole world in view, centred
+void initCamera(Camera* camera, int viewWidth, int viewHeight, float worldSize) {
+    camera->viewWidth = viewWidth;
+    camera->viewHeight = viewHeight;
+    camera->centerX = worldSize / 2;
+    camera->centerY = worldSize / 2;
+    float fitX = viewWidth / worldSize, fitY = viewHeight / worldSize;
+    camera->zoom = fitX < fitY ? fitX : fitY;
+}
+
+void cameraResize(Camera* camera, int viewWidth, int viewHeight) {
+    camera->viewWidth = viewWidth;
+    camera->viewHeight = viewHeight;
+}
+
+// Moves the view by a drag of (dx, dy) pixels: the world follows the mouse
+void cameraPan(Camera* camera, float dxPixels, float dyPixels) {
+    camera->centerX -= dxPixels / camera->zoom;
+    camera->centerY -= dyPixels / camera->zoom;
+}
+
+// Zooms keeping the world point under (screenX, screenY) where it is
+void cameraZoomAt(Camera* camera, float factor, float screenX, float screenY) {
+    float worldX, worldY;
+    cameraToWorld(camera, screenX, screenY, &worldX, &worldY);
+    float zoom = camera->zoom * factor;
+    if (zoom < CAMERA_MIN_ZOOM) zoom = CAMERA_MIN_ZOOM;
+    if (zoom > CAMERA_MAX_ZOOM) zoom = CAMERA_MAX_ZOOM;
+    camera->zoom = zoom;
+    camera->centerX = worldX - (screenX - camera->viewWidth / 2.0f) / zoom;
+    camera->centerY = worldY - (screenY - camera->viewHeight / 2.0f) / zoom;
+}
+
+void cameraToScreen(const Camera* camera, float worldX, float worldY, float* screenX, float* screenY) {
+    *screenX = (worldX - camera->centerX) * camera->zoom + camera->viewWidth / 2.0f;
+    *screenY = (worldY - camera->centerY) * camera->zoom + camera->viewHeight / 2.0f;
+}
+
+void cameraToWorld(const Camera* camera, float screenX, float screenY, float* worldX, float* worldY) {
+    *worldX = (screenX - camera->viewWidth / 2.0f) / camera->zoom + camera->centerX;
+    *worldY = (screenY - camera->viewHeight / 2.0f) / camera->zoom + camera->centerY;
+}
+
+// World rectangle covered by the window
+void cameraVisibleWorld(const Camera* camera, float* minX, float* minY, float* maxX, float* maxY) {
+    cameraToWorld(camera, 0, 0, minX, minY);
+    cameraToWorld(camera, camera->viewWidth, camera->viewHeight, maxX, maxY);
+}
+
+// Whether any part of a world rectangle is on screen
+bool cameraSees(const Camera* camera, float minX, float minY, float maxX, float maxY) {
+    float viewMinX, viewMinY, viewMaxX, viewMaxY;
+    cameraVisibleWorld(camera, &viewMinX, &viewMinY, &viewMaxX, &viewMaxY);
+    return maxX >= viewMinX && minX <= viewMaxX && maxY >= viewMinY && minY <= viewMaxY;
+}
+
+void cameraFillRect(GeometryBatch* batch, const Camera* camera, float x, float y, float w, float h, SDL_Color color) {
+    if (!cameraSees(camera, x, y, x + w, y + h)) return;
+    float sx, sy;
+    cameraToScreen(camera, x, y, &sx, &sy);
+    batchFillRect(batch, sx, sy, w * camera->zoom, h * camera->zoom, color);
+}
+
+void cameraDrawRect(GeometryBatch* batch, const Camera* camera, float x, float y, float w, float h, SDL_Color color) {
+    if (!cameraSees(camera, x, y, x + w, y + h)) return;
+    float sx, sy;
+    cameraToScreen(camera, x, y, &sx, &sy);
+    batchDrawRect(batch, sx, sy, w * camera->zoom, h * camera->zoom, color);
+}
+
+void cameraDrawLine(GeometryBatch* batch, const Camera* camera, float x1, float y1, float x2, float y2, SDL_Color color) {
+    if (!cameraSees(camera, x1 < x2 ? x1 : x2, y1 < y2 ? y1 : y2, x1 > x2 ? x1 : x2, y1 > y2 ? y1 : y2)) return;
+    float sx1, sy1, sx2, sy2;
+    cameraToScreen(camera, x1, y1, &sx1, &sy1);
+    cameraToScreen(camera, x2, y2, &sx2, &sy2);
+    batchDrawLine(batch, sx1, sy1, sx2, sy2, color);
+}
+
+void cameraTriangle(GeometryBatch* batch, const Camera* camera, float x1, float y1, float x2, float y2,
+                    float x3, float y3, SDL_Color color) {
+    float sx1, sy1, sx2, sy2, sx3, sy3;
+    cameraToScreen(camera, x1, y1, &sx1, &sy1);
+    cameraToScreen(camera, x2, y2, &sx2, &sy2);
+    cameraToScreen(camera, x3, y3, &sx3, &sy3);
+    batchTriangle(batch, sx1, sy1, sx2, sy2, sx3, sy3, color);
+}
@@ -0,0 +1,34 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+#include <stdbool.h>
+#include "renderBatch.h"
+
+#define CAMERA_MIN_ZOOM 0.05f
+#define CAMERA_MAX_ZOOM 8.0f
+
+// View onto the world: which world point sits in the middle of the window
+// and how many pixels one world unit takes. Everything in the world is
+// drawn through it; HUD text is drawn in window pixels directly.
+typedef struct {
+    float centerX, centerY;  // World coordinates
+    float zoom;              // Pixels per world unit
+    int viewWidth, viewHeight;
+} Camera;
+
+void initCamera(Camera* camera, int viewWidth, int viewHeight, float worldSize);
+void cameraResize(Camera* camera, int viewWidth, int viewHeight);
+void cameraPan(Camera* camera, float dxPixels, float dyPixels);
+void cameraZoomAt(Camera* camera, float factor, float screenX, float screenY);
+void cameraToScreen(const Camera* camera, float worldX, float worldY, float* screenX, float* screenY);
+void cameraToWorld(const Camera* camera, float screenX, float screenY, float* worldX, float* worldY);
+void cameraVisibleWorld(const Camera* camera, float* minX, float* minY, float* maxX, float* maxY);
+bool cameraSees(const Camera* camera, float minX, float minY, float maxX, float maxY);
+
+// World-space versions of the batch calls; anything off screen is skipped
+void cameraFillRect(GeometryBatch* batch, const Camera* camera, float x, float y, float w, float h, SDL_Color color);
+void cameraDrawRect(GeometryBatch* batch, const Camera* camera, float x, float y, float w, float h, SDL_Color color);
+void cameraDrawLine(GeometryBatch* batch, const Camera* camera, float x1, float y1, float x2, float y2, SDL_Color color);
+void cameraTriangle(GeometryBatch* batch, const Camera* camera, float x1, float y1, float x2, float y2,
+                    float x3, float y3, SDL_Color color);
+
+#endif
@@ -0,0 +1,320 @@
+#include "checkpoint.h"
+#include "route.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+void initCheckpointImage(CheckpointImage* image) {
+    memset(image, 0, sizeof(*image));
+}
+
+void freeCheckpointImage(CheckpointImage* image) {
+    free(image->queued);
+    free(image->staged);
+    free(image->active);
+    initCheckpointImage(image);
+}
+
+// Grows *items so it can hold `needed` records of `size` bytes
+static bool reserveRecords(void** items, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) return true;
+    int newCapacity = *capacity > 0 ? *capacity : 64;
+    while (newCapacity < needed) newCapacity *= 2;
+    void* grown = realloc(*items, size * newCapacity);
+    if (grown == NULL) {
+        printf("Error: could not grow checkpoint buffer to %d records\n", newCapacity);
+        return false;
+    }
+    *items = grown;
+    *capacity = newCapacity;
+    return true;
+}
+
+static void packVehicle(Road* roads[MAX_ROADS], const Vehicle* vehicle, CheckpointVehicle* record) {
+    memset(record->name, 0, sizeof(record->name));
+    memcpy(record->name, vehicle->VechicleName, sizeof(record->name));
+    laneToIndex(roads, vehicle->currentLane, &record->roadIndex, &record->laneIndex);
+    laneToIndex(roads, vehicle->destinationLane, &record->destRoadIndex, &record->destLaneIndex);
+    record->position = vehicle->position;
+    record->speed = vehicle->speed;
+    record->arrivalTick = vehicle->arrivalTick;
+    record->releaseTick = vehicle->releaseTick;
+}
+
+static bool unpackVehicle(Road* roads[MAX_ROADS], const CheckpointVehicle* record, Vehicle* vehicle) {
+    memset(vehicle, 0, sizeof(*vehicle));
+    setVehiclePlate(vehicle, record->name);
+    vehicle->currentLane = indexToLane(roads, record->roadIndex, record->laneIndex);
+    vehicle->destinationLane = indexToLane(roads, record->destRoadIndex, record->destLaneIndex);
+    vehicle->position = record->position;
+    vehicle->speed = record->speed;
+    vehicle->arrivalTick = record->arrivalTick;
+    vehicle->releaseTick = record->releaseTick;
+    if (vehicle->currentLane == NULL || vehicle->destinationLane == NULL) {
+        printf("Error: checkpoint vehicle %.8s has an invalid lane\n", record->name);
+        return false;
+    }
+    vehicle->road = vehicle->currentLane->road;
+    return true;
+}
+
+// Copies the world into image. Must run on the simulation thread between
+// ticks so the active set is not changing underneath it.
+bool captureCheckpoint(CheckpointImage* image, Road* roads[MAX_ROADS], ActiveSet* set,
+                       ArrivalStaging staging[MAX_ROADS], unsigned long long tick, int currentLight, int nextLight,
+                       const JunctionStats* stats, const WaitHistogram laneWaits[LANE_SLOTS]) {
+    image->tick = tick;
+    image->currentLight = currentLight;
+    image->nextLight = nextLight;
+    image->stats = *stats;
+    memcpy(image->laneWaits, laneWaits, sizeof(image->laneWaits));
+
+    image->queuedCount = 0;
+    for (int i = 0; i < MAX_ROADS; i++) {
+        for (int j = 0; j < MAX_LANE_SIZE; j++) {
+            VehicleQueue* queue = &roads[i]->lanes[j].queue;
+            pthread_mutex_lock(&queue->mutex);
+            if (!reserveRecords((void**)&image->queued, &image->queuedCapacity,
+                                image->queuedCount + queue->count, sizeof(CheckpointVehicle))) {
+                pthread_mutex_unlock(&queue->mutex);
+                return false;
+            }
+            for (int k = 0; k < queue->count; k++) {
+                Vehicle* vehicle = &queue->vehicles[(queue->front + k) % QUEUE_SIZE];
+                packVehicle(roads, vehicle, &image->queued[image->queuedCount++]);
+            }
+            pthread_mutex_unlock(&queue->mutex);
+        }
+    }
+
+    image->stagedCount = 0;
+    for (int i = 0; i < MAX_ROADS; i++) {
+        pthread_mutex_lock(&staging[i].lock);
+        if (!reserveRecords((void**)&image->staged, &image->stagedCapacity,
+                            image->stagedCount + staging[i].count, sizeof(CheckpointVehicle))) {
+            pthread_mutex_unlock(&staging[i].lock);
+            return false;
+        }
+        for (int k = 0; k < staging[i].count; k++) {
+            packVehicle(roads, &staging[i].pending[k], &image->staged[image->stagedCount++]);
+        }
+        pthread_mutex_unlock(&staging[i].lock);
+    }
+
+    if (!reserveRecords((void**)&image->active, &image->activeCapacity,
+                        set->count, sizeof(CheckpointActive))) {
+        return false;
+    }
+    for (int i = 0; i < set->count; i++) {
+        const VehicleUI* vui = &set->vehicles[i];
+        CheckpointActive* record = &image->active[i];
+        packVehicle(roads, &vui->vehicle, &record->vehicle);
+        record->x = vui->x;
+        record->y = vui->y;
+        record->prevX = vui->prevX;
+        record->prevY = vui->prevY;
+        record->distance = vui->distance;
+        record->isMoving = vui->isMoving;
+        record->hasArrived = vui->hasArrived;
+    }
+    image->activeCount = set->count;
+    return true;
+}
+
+// Writes to a temporary file and renames it over the target, so a crash
+// mid-write leaves the previous checkpoint intact
+bool saveCheckpoint(const char* path, const CheckpointImage* image) {
+    char tempPath[300];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+    FILE* file = fopen(tempPath, "wb");
+    if (!file) {
+        perror("Error opening checkpoint file");
+        return false;
+    }
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CHECKPOINT_MAGIC;
+    header.version = CHECKPOINT_VERSION;
+    header.vehicleRecordSize = sizeof(CheckpointVehicle);
+    header.activeRecordSize = sizeof(CheckpointActive);
+    header.histogramSize = sizeof(WaitHistogram);
+    header.tick = image->tick;
+    header.currentLight = image->currentLight;
+    header.nextLight = image->nextLight;
+    header.queuedCount = image->queuedCount;
+    header.stagedCount = image->stagedCount;
+    header.activeCount = image->activeCount;
+    header.stats = image->stats;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(image->laneWaits, sizeof(WaitHistogram), LANE_SLOTS, file) == LANE_SLOTS;
+    ok = ok && fwrite(image->queued, sizeof(CheckpointVehicle), image->queuedCount, file) == (size_t)image->queuedCount;
+    ok = ok && fwrite(image->staged, sizeof(CheckpointVehicle), image->stagedCount, file) == (size_t)image->stagedCount;
+    ok = ok && fwrite(image->active, sizeof(CheckpointActive), image->activeCount, file) == (size_t)image->activeCount;
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || rename(tempPath, path) != 0) {
+        perror("Error writing checkpoint");
+        remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+bool loadCheckpoint(const char* path, CheckpointImage* image) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror("Error opening checkpoint file");
+        return false;
+    }
+
+    CheckpointHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION ||
+        header.vehicleRecordSize != sizeof(CheckpointVehicle) ||
+        header.activeRecordSize != sizeof(CheckpointActive) ||
+        header.histogramSize != sizeof(WaitHistogram) ||
+        header.queuedCount < 0 || header.stagedCount < 0 || header.activeCount < 0) {
+        printf("Error: %s is not a checkpoint written by this build\n", path);
+        fclose(file);
+        return false;
+    }
+
+    bool ok = reserveRecords((void**)&image->queued, &image->queuedCapacity,
+                             header.queuedCount, sizeof(CheckpointVehicle))
+           && reserveRecords((void**)&image->staged, &image->stagedCapacity,
+                             header.stagedCount, sizeof(CheckpointVehicle))
+           && reserveRecords((void**)&image->active, &image->activeCapacity,
+                             header.activeCount, sizeof(CheckpointActive));
+    ok = ok && fread(image->laneWaits, sizeof(WaitHistogram), LANE_SLOTS, file) == LANE_SLOTS;
+    ok = ok && fread(image->queued, sizeof(CheckpointVehicle), header.queuedCount, file) == (size_t)header.queuedCount;
+    ok = ok && fread(image->staged, sizeof(CheckpointVehicle), header.stagedCount, file) == (size_t)header.stagedCount;
+    ok = ok && fread(image->active, sizeof(CheckpointActive), header.activeCount, file) == (size_t)header.activeCount;
+    fclose(file);
+    if (!ok) {
+        printf("Error: checkpoint %s is truncated\n", path);
+        return false;
+    }
+
+    image->tick = header.tick;
+    image->currentLight = header.currentLight;
+    image->nextLight = header.nextLight;
+    image->queuedCount = header.queuedCount;
+    image->stagedCount = header.stagedCount;
+    image->activeCount = header.activeCount;
+    image->stats = header.stats;
+    return true;
+}
+
+// Puts a loaded image back into freshly initialized roads and an empty set
+bool restoreCheckpoint(const CheckpointImage* image, Road* roads[MAX_ROADS], ActiveSet* set,
+                       ArrivalStaging staging[MAX_ROADS]) {
+    Vehicle vehicle;
+    int roadIndex, laneIndex;
+
+    for (int i = 0; i < image->queuedCount; i++) {
+        if (!unpackVehicle(roads, &image->queued[i], &vehicle)) return false;
+        if (!enqueue(&vehicle.currentLane->queue, vehicle)) {
+            printf("Error: lane %s overflowed while restoring\n", vehicle.currentLane->laneName);
+            return false;
+        }
+    }
+    for (int i = 0; i < image->stagedCount; i++) {
+        if (!unpackVehicle(roads, &image->staged[i], &vehicle)) return false;
+        laneToIndex(roads, vehicle.currentLane, &roadIndex, &laneIndex);
+        if (!stageArrival(&staging[roadIndex], vehicle)) return false;
+    }
+    for (int i = 0; i < image->activeCount; i++) {
+        const CheckpointActive* record = &image->active[i];
+        if (!unpackVehicle(roads, &record->vehicle, &vehicle)) return false;
+        // Bypasses the admission policy: these vehicles were already admitted
+        VehicleUI* vui = activeSetAdd(set);
+        if (vui == NULL) return false;
+        memset(vui, 0, sizeof(*vui));
+        vui->vehicle = vehicle;
+        vui->x = record->x;
+        vui->y = record->y;
+        vui->prevX = record->prevX;
+        vui->prevY = record->prevY;
+        vui->distance = record->distance;
+        vui->fixedDistance = (int)lrintf(record->distance * ROUTE_FIXED_ONE);
+        vui->route = routeIndex(record->vehicle.roadIndex, record->vehicle.laneIndex,
+                                record->vehicle.destRoadIndex, record->vehicle.destLaneIndex);
+        vui->isMoving = record->isMoving;
+        vui->hasArrived = record->hasArrived;
+    }
+    return true;
+}
+
+static void* checkpointWriterMain(void* arg) {
+    CheckpointWriter* writer = (CheckpointWriter*)arg;
+
+    while (1) {
+        pthread_mutex_lock(&writer->lock);
+        while (!writer->hasPending && !writer->stopping) {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+        if (!writer->hasPending) {
+            pthread_mutex_unlock(&writer->lock);
+            return NULL;
+        }
+        CheckpointImage* ready = writer->pending;
+        writer->pending = writer->writing;
+        writer->writing = ready;
+        writer->hasPending = false;
+        pthread_mutex_unlock(&writer->lock);
+
+        if (saveCheckpoint(writer->path, writer->writing)) {
+            printf("Checkpoint written at tick %llu (%d queued, %d in flight)\n",
+                   writer->writing->tick, writer->writing->queuedCount, writer->writing->activeCount);
+        }
+    }
+}
+
+bool startCheckpointWriter(CheckpointWriter* writer, const char* path) {
+    for (int i = 0; i < 3; i++) initCheckpointImage(&writer->images[i]);
+    writer->capture = &writer->images[0];
+    writer->pending = &writer->images[1];
+    writer->writing = &writer->images[2];
+    writer->hasPending = false;
+    writer->stopping = false;
+    snprintf(writer->path, sizeof(writer->path), "%s", path);
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+
+    if (pthread_create(&writer->thread, NULL, checkpointWriterMain, writer) != 0) {
+        printf("Error: could not start checkpoint writer\n");
+        return false;
+    }
+    return true;
+}
+
+// Flushes any pending checkpoint and stops the writer thread
+void stopCheckpointWriter(CheckpointWriter* writer) {
+    pthread_mutex_lock(&writer->lock);
+    writer->stopping = true;
+    pthread_cond_signal(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    for (int i = 0; i < 3; i++) freeCheckpointImage(&writer->images[i]);
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->lock);
+}
+
+// Hands the freshly captured image to the writer. If the writer has not
+// picked up the previous one yet, that older image is simply replaced.
+void submitCheckpoint(CheckpointWriter* writer) {
+    pthread_mutex_lock(&writer->lock);
+    CheckpointImage* captured = writer->capture;
+    writer->capture = writer->pending;
+    writer->pending = captured;
+    writer->hasPending = true;
+    pthread_cond_signal(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+}
@@ -0,0 +1,101 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include <stdbool.h>
+#include <pthread.h>
+#include "dataManagement.h"
+#include "activeSet.h"
+#include "junction.h"
+#include "laneScheduler.h"
+
+#define CHECKPOINT_MAGIC 0x4B434E4A // "JNCK"
+#define CHECKPOINT_VERSION 7
+
+// Vehicle with its lane pointers replaced by road/lane indices
+typedef struct {
+    char name[PLATE_SIZE];
+    int roadIndex;
+    int laneIndex;
+    int destRoadIndex;
+    int destLaneIndex;
+    int position;
+    int speed;
+    unsigned long long arrivalTick;
+    unsigned long long releaseTick;
+} CheckpointVehicle;
+
+// In-flight vehicle: the plain vehicle plus its motion state
+typedef struct {
+    CheckpointVehicle vehicle;
+    float x, y;
+    float prevX, prevY;
+    float distance;       // Along the route, which follows from the lanes
+    bool isMoving;
+    bool hasArrived;
+} CheckpointActive;
+
+// File header. The record sizes guard against restoring a file written by
+// a build with a different struct layout.
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int vehicleRecordSize;
+    unsigned int activeRecordSize;
+    unsigned int histogramSize;
+    unsigned long long tick;
+    int currentLight;
+    int nextLight;
+    int queuedCount;
+    int stagedCount;
+    int activeCount;
+    JunctionStats stats;
+} CheckpointHeader;
+
+// Flat, pointer-free copy of the whole world state
+typedef struct {
+    unsigned long long tick;
+    int currentLight;
+    int nextLight;
+    CheckpointVehicle* queued;   // Lane queues, each lane front to rear
+    int queuedCount;
+    int queuedCapacity;
+    CheckpointVehicle* staged;   // Arrivals not yet merged into the set
+    int stagedCount;
+    int stagedCapacity;
+    CheckpointActive* active;
+    int activeCount;
+    int activeCapacity;
+    JunctionStats stats;         // Running totals, so they carry on after a restore
+    WaitHistogram laneWaits[LANE_SLOTS]; // Queue waits so far, per lane; written after the header
+} CheckpointImage;
+
+// Background writer. The simulation thread copies the world into `capture`
+// and swaps it into `pending`; the writer swaps `pending` into `writing`
+// and saves it, so disk I/O never runs on the simulation thread.
+typedef struct {
+    CheckpointImage images[3];
+    CheckpointImage* capture;
+    CheckpointImage* pending;
+    CheckpointImage* writing;
+    bool hasPending;
+    bool stopping;
+    char path[256];
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} CheckpointWriter;
+
+void initCheckpointImage(CheckpointImage* image);
+void freeCheckpointImage(CheckpointImage* image);
+bool captureCheckpoint(CheckpointImage* image, Road* roads[MAX_ROADS], ActiveSet* set,
+                       ArrivalStaging staging[MAX_ROADS], unsigned long long tick, int currentLight, int nextLight,
+                       const JunctionStats* stats, const WaitHistogram laneWaits[LANE_SLOTS]);
+bool saveCheckpoint(const char* path, const CheckpointImage* image);
+bool loadCheckpoint(const char* path, CheckpointImage* image);
+bool restoreCheckpoint(const CheckpointImage* image, Road* roads[MAX_ROADS], ActiveSet* set,
+                       ArrivalStaging staging[MAX_ROADS]);
+
+bool startCheckpointWriter(CheckpointWriter* writer, const char* path);
+void stopCheckpointWriter(CheckpointWriter* writer);
+void submitCheckpoint(CheckpointWriter* writer);
+
+#endif
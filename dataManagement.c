@@ -1,17 +1,19 @@
 #include "dataManagement.h"
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_ttf.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
+
+_Static_assert(offsetof(VehicleQueue, count) + sizeof(int) <= CACHE_LINE_SIZE,
+               "queue lock and indices must share one cache line");
 
 void initializeQueue(VehicleQueue* queue) {
     queue->front = 0;
     queue->rear = 0;
     queue->count = 0;
-    queue->mutex = SDL_CreateMutex();
-    queue->cond = SDL_CreateCond();
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->cond, NULL);
 }
 
 bool enqueue(VehicleQueue* queue, Vehicle vehicle) {
@@ -19,139 +21,92 @@ bool enqueue(VehicleQueue* queue, Vehicle vehicle) {
         printf("Error:Queue is  not initialized in lane\n");
         return false;
     }
-    if(queue->mutex==NULL){
-        printf("Error: Mutex is not initialized for queue\n");
-        return false;
-    }
-    SDL_LockMutex(queue->mutex);
+    pthread_mutex_lock(&queue->mutex);
 
     if (queue->count < QUEUE_SIZE) {
         queue->vehicles[queue->rear] = vehicle; // Add vehicle to the queue
         queue->rear = (queue->rear + 1) % QUEUE_SIZE; // Move rear index forward
-        queue->count++; 
-        printf("Vehicle hase been successfully added:\n");// Increment vehicle count
-        SDL_CondSignal(queue->cond); // Signal that a vehicle has been added
-        SDL_UnlockMutex(queue->mutex);
+        queue->count++; // Increment vehicle count
+        pthread_cond_signal(&queue->cond); // Signal that a vehicle has been added
+        pthread_mutex_unlock(&queue->mutex);
         return true; // Successfully added
     }
     
 
-    SDL_UnlockMutex(queue->mutex);
+    pthread_mutex_unlock(&queue->mutex);
     return false; // Queue is full
 }
 
 Vehicle dequeue(VehicleQueue* queue) {
-    SDL_LockMutex(queue->mutex);
+    pthread_mutex_lock(&queue->mutex);
 
     while (queue->count == 0) {
-        SDL_CondWait(queue->cond, queue->mutex);
+        pthread_cond_wait(&queue->cond, &queue->mutex);
     }
 
+    Vehicle vehicle = dequeueLocked(queue);
+    pthread_mutex_unlock(&queue->mutex);
+    return vehicle;
+}
+
+// For callers that already hold queue->mutex and know the queue is not empty
+Vehicle dequeueLocked(VehicleQueue* queue) {
     Vehicle vehicle = queue->vehicles[queue->front]; // Get the vehicle from the front
     queue->front = (queue->front + 1) % QUEUE_SIZE; // Move front index forward
     queue->count--; // Decrement vehicle count
-    SDL_UnlockMutex(queue->mutex);
     return vehicle;
 }
 
+// Names the vehicle and packs its ID. Reads at most PLATE_SIZE characters,
+// so `plate` may be a fixed-size record field without a terminator.
+void setVehiclePlate(Vehicle* vehicle, const char* plate) {
+    int i = 0;
+    for (; i < PLATE_SIZE && plate[i] != '\0'; i++) vehicle->VechicleName[i] = plate[i];
+    vehicle->VechicleName[i] = '\0';
+    vehicle->id = packPlate(vehicle->VechicleName);
+}
+
 void initializeRoads(Road* roads[MAX_ROADS]) {
     const char* roadNames[MAX_ROADS] = {"Road A", "Road B", "Road C", "Road D"};
 
     // Allocate memory for each road
     for (int i = 0; i < MAX_ROADS; i++) {
-        roads[i] = (Road*)malloc(sizeof(Road));
+        roads[i] = (Road*)aligned_alloc(CACHE_LINE_SIZE, sizeof(Road)); // sizeof is a whole number of lines
         if (roads[i] == NULL) {
             printf("Memory allocation failed for road %d\n", i);
             return;
         }
         
         strcpy(roads[i]->roadName, roadNames[i]);
-        printf("%s\n", roads[i]->roadName);
         
         for (int j = 0; j < MAX_LANE_SIZE; j++) {
             initializeQueue(&(roads[i]->lanes[j].queue));
             roads[i]->lanes[j].isPriority = false;
             snprintf(roads[i]->lanes[j].laneName, sizeof(roads[i]->lanes[j].laneName), 
                     "%s%d", roads[i]->roadName, j + 1);
-            printf("%s", roads[i]->lanes[j].laneName);
             roads[i]->lanes[j].road = roads[i];
         }
     }
 }
 
-Road* findRoad(Road* roads[MAX_ROADS], const char* roadName) {
+void freeRoads(Road* roads[MAX_ROADS]) {
     for (int i = 0; i < MAX_ROADS; i++) {
-        if (strcmp(roads[i]->roadName, roadName) == 0) {
-            return roads[i];
+        if (roads[i] == NULL) continue;
+        for (int j = 0; j < MAX_LANE_SIZE; j++) {
+            pthread_mutex_destroy(&roads[i]->lanes[j].queue.mutex);
+            pthread_cond_destroy(&roads[i]->lanes[j].queue.cond);
         }
-    }
-    return NULL;
-}
-
-void addVehicleToRandomLaneWithDestinationLane(Road* roads[MAX_ROADS],Road* roadPassed, Vehicle vehicle) {
-    if (roadPassed == NULL) {
-        printf("Road not found.\n");
-        return ;
-    }  
-    
-    int laneIndex = rand() % MAX_LANE_SIZE;   
-    Lane* selectedLane=&(roadPassed->lanes[laneIndex]);
-
-    printf("Attempting to add Vehicle %s to Lane %d of Road %s\n", 
-           vehicle.VechicleName, laneIndex + 1, roadPassed->roadName);
-    Lane* destinationLane = generateDestination(selectedLane, roads);
-
-    printf("Generated destination Lane %s\n",destinationLane->laneName);
-    if(destinationLane!=NULL){
-        vehicle.destinationLane=destinationLane;
-    }
-    
-    if (enqueue(&selectedLane->queue, vehicle)) {
-        printf("enqueuing vehicle after updating destinationLane.\n");
-        
+        free(roads[i]);
+        roads[i] = NULL;
     }
 }
 
-Lane* generateDestination(Lane* randomSourceLane, Road* roads[MAX_ROADS]) {
-    Lane* destinationLane = NULL;
-    
-    if (randomSourceLane == &roads[0]->lanes[3]) {
-        destinationLane = &roads[2]->lanes[0];
-        return destinationLane;
-    }
-    else if (randomSourceLane == &roads[0]->lanes[1]) {
-        Lane* options[] = {&roads[1]->lanes[1], &roads[3]->lanes[1]};
-        destinationLane = options[rand() % 2];
-        return destinationLane;
-    }
-    else if (randomSourceLane == &roads[1]->lanes[2]) {
-        destinationLane = &roads[2]->lanes[0];
-        return destinationLane;
-    } 
-    else if (randomSourceLane == &roads[1]->lanes[1]) {
-        Lane* options[] = {&roads[0]->lanes[1], &roads[2]->lanes[1]};
-        destinationLane = options[rand() % 2];
-        return destinationLane;
-    }
-    else if (randomSourceLane == &roads[2]->lanes[2]) {
-        destinationLane = &roads[1]->lanes[0];
-        return destinationLane;
-    }
-    else if (randomSourceLane == &roads[2]->lanes[1]) {
-        Lane* options[] = {&roads[0]->lanes[1], &roads[3]->lanes[1]};
-        destinationLane = options[rand() % 2];
-        return destinationLane;
-    }
-    else if (randomSourceLane == &roads[3]->lanes[2]) {
-        destinationLane = &roads[0]->lanes[0];
-        return destinationLane;
-    }
-    else if (randomSourceLane == &roads[3]->lanes[1]) {
-        Lane* options[] = {&roads[2]->lanes[1], &roads[1]->lanes[1]};
-        destinationLane = options[rand() % 2];
-        return destinationLane;
+Road* findRoad(Road* roads[MAX_ROADS], const char* roadName) {
+    for (int i = 0; i < MAX_ROADS; i++) {
+        if (strcmp(roads[i]->roadName, roadName) == 0) {
+            return roads[i];
+        }
     }
-    
     return NULL;
 }
 
@@ -164,4 +119,24 @@ void printRoads(Road* roads[MAX_ROADS]) {
                    j + 1, lane->queue.count, lane->isPriority ? "Yes" : "No");
         }
     }
+}
+
+// Turns a lane pointer into road/lane indices; -1/-1 when it is not a known lane
+void laneToIndex(Road* roads[MAX_ROADS], const Lane* lane, int* roadIndex, int* laneIndex) {
+    *roadIndex = -1;
+    *laneIndex = -1;
+    if (lane == NULL) return;
+    for (int i = 0; i < MAX_ROADS; i++) {
+        if (lane->road == roads[i]) {
+            *roadIndex = i;
+            *laneIndex = (int)(lane - roads[i]->lanes);
+            return;
+        }
+    }
+}
+
+Lane* indexToLane(Road* roads[MAX_ROADS], int roadIndex, int laneIndex) {
+    if (roadIndex < 0 || roadIndex >= MAX_ROADS) return NULL;
+    if (laneIndex < 0 || laneIndex >= MAX_LANE_SIZE) return NULL;
+    return &roads[roadIndex]->lanes[laneIndex];
 }
\ No newline at end of file
@@ -1,12 +1,14 @@
 #ifndef DATAMANAGEMENT_H
 #define DATAMANAGEMENT_H
 #include <stdbool.h>
-#include <SDL2/SDL.h>
+#include <pthread.h>
+#include "plateId.h"
 
 #define QUEUE_SIZE 10
 #define MAX_ROADS 4
 #define MAX_VEHICLE_QUEUE_SIZE 15
 #define MAX_LANE_SIZE 3
+#define CACHE_LINE_SIZE 64
 
 // Forward declarations
 typedef struct VehicleQueue VehicleQueue;
@@ -15,49 +17,55 @@ typedef struct Road Road;
 
 // Vehicle struct
 typedef struct {
-    char VechicleName[7];
+    char VechicleName[PLATE_SIZE + 1];
+    PlateId id;                     // VechicleName packed, for lookups
     Lane* currentLane;
     int position;
     int speed;
     Road* road;
     Lane* destinationLane;
+    unsigned long long arrivalTick; // Tick the vehicle joined its lane queue
+    unsigned long long releaseTick; // Tick it left the queue on green, 0 while queued
 } Vehicle;
 
-// VehicleQueue struct
+// VehicleQueue struct. The lock and the indices it guards fill one cache
+// line of their own and the vehicles start on the next, so locking one
+// lane never drags in another lane's indices or its payload.
 struct VehicleQueue {
-    Vehicle vehicles[MAX_VEHICLE_QUEUE_SIZE];
+    _Alignas(CACHE_LINE_SIZE) pthread_mutex_t mutex;
     int front;
     int rear;
     int count;
-    SDL_mutex* mutex;
-    SDL_cond* cond;
+    _Alignas(CACHE_LINE_SIZE) Vehicle vehicles[MAX_VEHICLE_QUEUE_SIZE];
+    pthread_cond_t cond;  // Only a blocking dequeue waits on it
 };
 
-// Lane struct
+// Lane struct. Hot fields first; the name is only read for printing.
 struct Lane {
-    bool isPriority;
-    char laneName[30];
-    int VehiclesNo;
     VehicleQueue queue;
     Road* road;
- 
-
+    bool isPriority;
+    int VehiclesNo;
+    char laneName[30];
 };
 
-// Road struct
+// Road struct. Lanes are whole cache lines, so neighbours never share one.
 struct Road {
-    char roadName[20];
     Lane lanes[MAX_LANE_SIZE]; // Road contains an array of Lane
+    char roadName[20];
 };
 
 // Updated function prototypes to use array of pointers
 void initializeRoads(Road* roads[MAX_ROADS]);
+void freeRoads(Road* roads[MAX_ROADS]);
 Road* findRoad(Road* roads[MAX_ROADS], const char* roadName);
+void setVehiclePlate(Vehicle* vehicle, const char* plate);
 void initializeQueue(VehicleQueue* queue);
 bool enqueue(VehicleQueue* queue, Vehicle vehicle);
 Vehicle dequeue(VehicleQueue* queue);
-void addVehicleToRandomLaneWithDestinationLane(Road* roads[MAX_ROADS],Road* roadPassed, Vehicle vehicle);
-Lane* generateDestination(Lane* randomSourceLane, Road* roads[MAX_ROADS]);
+Vehicle dequeueLocked(VehicleQueue* queue);
 void printRoads(Road* roads[MAX_ROADS]);
+void laneToIndex(Road* roads[MAX_ROADS], const Lane* lane, int* roadIndex, int* laneIndex);
+Lane* indexToLane(Road* roads[MAX_ROADS], int roadIndex, int laneIndex);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "frameExport.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define PNG_STORED_BLOCK 65535  // Largest stored deflate block
+
+// "ppm", "raw" or "png"
+bool parseFrameFormat(const char* text, int* format) {
+    if (strcmp(text, "ppm") == 0) *format = FRAME_FORMAT_PPM;
+    else if (strcmp(text, "raw") == 0) *format = FRAME_FORMAT_RAW;
+    else if (strcmp(text, "png") == 0) *format = FRAME_FORMAT_PNG;
+    else {
+        printf("Unknown frame format: %s (use ppm, raw or png)\n", text);
+        return false;
+    }
+    return true;
+}
+
+static unsigned long crcTable[256];
+
+static void buildCrcTable(void) {
+    for (unsigned long n = 0; n < 256; n++) {
+        unsigned long c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320UL ^ (c >> 1) : c >> 1;
+        crcTable[n] = c;
+    }
+}
+
+static unsigned long updateCrc(unsigned long crc, const unsigned char* bytes, size_t length) {
+    for (size_t i = 0; i < length; i++) crc = crcTable[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static void putBigEndian(unsigned char* out, unsigned long value) {
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+static size_t pngRawSize(const FrameExporter* exporter) {
+    return (size_t)exporter->height * (1 + (size_t)exporter->width * 3);
+}
+
+// zlib stream of stored blocks: no compression, so encoding costs about
+// as much as a copy and the writer keeps up with the render loop
+static size_t pngDataSize(const FrameExporter* exporter) {
+    size_t raw = pngRawSize(exporter);
+    size_t blocks = (raw + PNG_STORED_BLOCK - 1) / PNG_STORED_BLOCK;
+    return 2 + raw + blocks * 5 + 4;
+}
+
+static bool writeChunk(FILE* file, const char* type, const unsigned char* data, size_t length) {
+    unsigned char header[8];
+    putBigEndian(header, (unsigned long)length);
+    memcpy(header + 4, type, 4);
+    unsigned long crc = updateCrc(0xffffffffUL, header + 4, 4);
+    crc = updateCrc(crc, data, length) ^ 0xffffffffUL;
+    unsigned char trailer[4];
+    putBigEndian(trailer, crc);
+    return fwrite(header, 1, 8, file) == 8 && fwrite(data, 1, length, file) == length &&
+           fwrite(trailer, 1, 4, file) == 4;
+}
+
+static bool writePng(FrameExporter* exporter, FILE* file, const unsigned char* pixels) {
+    static const unsigned char signature[8] = {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+    unsigned char header[13];
+    putBigEndian(header, exporter->width);
+    putBigEndian(header + 4, exporter->height);
+    header[8] = 8;   // Bits per channel
+    header[9] = 2;   // RGB
+    header[10] = header[11] = header[12] = 0;
+
+    // Rows with a "no filter" byte in front, split into stored blocks
+    unsigned char* out = exporter->encoded;
+    size_t raw = pngRawSize(exporter), row = (size_t)exporter->width * 3, done = 0;
+    unsigned long a = 1, b = 0;  // Adler-32 of the uncompressed rows
+    *out++ = 0x78;
+    *out++ = 0x01;
+    size_t y = 0, column = 0;  // Column 0 is the filter byte, pixel bytes follow
+    while (done < raw) {
+        size_t block = raw - done < PNG_STORED_BLOCK ? raw - done : PNG_STORED_BLOCK;
+        *out++ = done + block == raw;  // Final block flag
+        *out++ = (unsigned char)block;
+        *out++ = (unsigned char)(block >> 8);
+        *out++ = (unsigned char)~block;
+        *out++ = (unsigned char)(~block >> 8);
+        for (size_t i = 0; i < block; i++) {
+            unsigned char byte = column == 0 ? 0 : pixels[y * row + column - 1];
+            if (++column > row) {
+                column = 0;
+                y++;
+            }
+            *out++ = byte;
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        done += block;
+    }
+    putBigEndian(out, (b << 16) | a);
+
+    return fwrite(signature, 1, 8, file) == 8 && writeChunk(file, "IHDR", header, sizeof(header)) &&
+           writeChunk(file, "IDAT", exporter->encoded, pngDataSize(exporter)) &&
+           writeChunk(file, "IEND", NULL, 0);
+}
+
+static bool writeFrame(FrameExporter* exporter, const unsigned char* pixels, unsigned long frameNumber) {
+    static const char* extensions[] = {"ppm", "rgb", "png"};
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame_%06lu.%s", exporter->directory, frameNumber,
+             extensions[exporter->format]);
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror("Error opening frame file");
+        return false;
+    }
+    size_t size = (size_t)exporter->width * exporter->height * 3;
+    bool ok;
+    if (exporter->format == FRAME_FORMAT_PNG) {
+        ok = writePng(exporter, file, pixels);
+    } else {
+        ok = exporter->format == FRAME_FORMAT_RAW ||
+             fprintf(file, "P6\n%d %d\n255\n", exporter->width, exporter->height) > 0;
+        ok = ok && fwrite(pixels, 1, size, file) == size;
+    }
+    if (fclose(file) != 0) ok = false;
+    if (!ok) printf("Error writing frame %s\n", path);
+    return ok;
+}
+
+// Writer thread: takes queued frames oldest first and hands each buffer
+// back once its file is written. Drains the queue before it exits.
+static void* runFrameWriter(void* arg) {
+    FrameExporter* exporter = (FrameExporter*)arg;
+    pthread_mutex_lock(&exporter->lock);
+    while (true) {
+        while (exporter->queueCount == 0 && !exporter->stopping) {
+            pthread_cond_wait(&exporter->ready, &exporter->lock);
+        }
+        if (exporter->queueCount == 0) break;
+        int buffer = exporter->queue[exporter->queueHead];
+        unsigned long frameNumber = exporter->frameNumbers[exporter->queueHead];
+        exporter->queueHead = (exporter->queueHead + 1) % FRAME_EXPORT_BUFFERS;
+        exporter->queueCount--;
+        pthread_mutex_unlock(&exporter->lock);
+
+        bool ok = writeFrame(exporter, exporter->buffers[buffer], frameNumber);
+
+        pthread_mutex_lock(&exporter->lock);
+        if (ok) exporter->written++;
+        else exporter->failed++;
+        exporter->freeList[exporter->freeCount++] = buffer;
+    }
+    pthread_mutex_unlock(&exporter->lock);
+    return NULL;
+}
+
+// Creates the directory if needed, allocates the buffers and starts the writer
+bool startFrameExport(FrameExporter* exporter, const char* directory, int format, int width, int height) {
+    memset(exporter, 0, sizeof(*exporter));
+    exporter->directory = directory;
+    exporter->format = format;
+    exporter->width = width;
+    exporter->height = height;
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        perror("Error creating frame directory");
+        return false;
+    }
+    for (int i = 0; i < FRAME_EXPORT_BUFFERS; i++) {
+        exporter->buffers[i] = (unsigned char*)malloc((size_t)width * height * 3);
+        if (!exporter->buffers[i]) {
+            printf("Error: could not allocate frame export buffers\n");
+            for (int j = 0; j < i; j++) free(exporter->buffers[j]);
+            return false;
+        }
+        exporter->freeList[exporter->freeCount++] = i;
+    }
+    if (format == FRAME_FORMAT_PNG) {
+        buildCrcTable();
+        exporter->encoded = (unsigned char*)malloc(pngDataSize(exporter));
+        if (!exporter->encoded) {
+            printf("Error: could not allocate PNG buffer\n");
+            for (int i = 0; i < FRAME_EXPORT_BUFFERS; i++) free(exporter->buffers[i]);
+            return false;
+        }
+    }
+    pthread_mutex_init(&exporter->lock, NULL);
+    pthread_cond_init(&exporter->ready, NULL);
+    if (pthread_create(&exporter->writer, NULL, runFrameWriter, exporter) != 0) {
+        printf("Error: could not start frame writer thread\n");
+        pthread_mutex_destroy(&exporter->lock);
+        pthread_cond_destroy(&exporter->ready);
+        for (int i = 0; i < FRAME_EXPORT_BUFFERS; i++) free(exporter->buffers[i]);
+        free(exporter->encoded);
+        return false;
+    }
+    return true;
+}
+
+// A free buffer to read a frame into, or -1 if the writer is behind and
+// this frame should be skipped. Never waits.
+int acquireExportBuffer(FrameExporter* exporter) {
+    int buffer = -1;
+    pthread_mutex_lock(&exporter->lock);
+    if (exporter->freeCount > 0) buffer = exporter->freeList[--exporter->freeCount];
+    else exporter->dropped++;
+    pthread_mutex_unlock(&exporter->lock);
+    return buffer;
+}
+
+// Queues a filled buffer for the writer
+void submitExportFrame(FrameExporter* exporter, int buffer, unsigned long frameNumber) {
+    pthread_mutex_lock(&exporter->lock);
+    int tail = (exporter->queueHead + exporter->queueCount) % FRAME_EXPORT_BUFFERS;
+    exporter->queue[tail] = buffer;
+    exporter->frameNumbers[tail] = frameNumber;
+    exporter->queueCount++;
+    pthread_cond_signal(&exporter->ready);
+    pthread_mutex_unlock(&exporter->lock);
+}
+
+// Gives a buffer back unwritten, e.g. when reading the pixels failed
+void releaseExportBuffer(FrameExporter* exporter, int buffer) {
+    pthread_mutex_lock(&exporter->lock);
+    exporter->freeList[exporter->freeCount++] = buffer;
+    pthread_mutex_unlock(&exporter->lock);
+}
+
+// Writes whatever is still queued, stops the writer and frees the buffers
+void stopFrameExport(FrameExporter* exporter) {
+    pthread_mutex_lock(&exporter->lock);
+    exporter->stopping = true;
+    pthread_cond_signal(&exporter->ready);
+    pthread_mutex_unlock(&exporter->lock);
+    pthread_join(exporter->writer, NULL);
+
+    printf("Frame export: %lu written, %lu dropped, %lu failed\n",
+           exporter->written, exporter->dropped, exporter->failed);
+    for (int i = 0; i < FRAME_EXPORT_BUFFERS; i++) free(exporter->buffers[i]);
+    free(exporter->encoded);
+    pthread_mutex_destroy(&exporter->lock);
+    pthread_cond_destroy(&exporter->ready);
+}
@@ -0,0 +1,41 @@
+#ifndef FRAMEEXPORT_H
+#define FRAMEEXPORT_H
+#include <stdbool.h>
+#include <pthread.h>
+
+#define FRAME_EXPORT_BUFFERS 8   // Frames that can be waiting for the writer at once
+
+#define FRAME_FORMAT_PPM 0   // Binary PPM (P6), one file per frame
+#define FRAME_FORMAT_RAW 1   // Bare RGB24 rows, one file per frame
+#define FRAME_FORMAT_PNG 2   // Uncompressed PNG, one file per frame
+
+// Frames read back from the renderer and written to disk by a thread of
+// their own. Buffers are allocated once and cycle between the free list
+// and the write queue; when the writer falls behind, new frames are
+// dropped rather than making the render loop wait for the disk.
+typedef struct {
+    const char* directory;
+    int format;
+    int width, height;               // Pixels; rows are width * 3 bytes of RGB
+    unsigned char* buffers[FRAME_EXPORT_BUFFERS];
+    int freeList[FRAME_EXPORT_BUFFERS];
+    int freeCount;
+    int queue[FRAME_EXPORT_BUFFERS]; // Buffers waiting to be written, oldest first
+    unsigned long frameNumbers[FRAME_EXPORT_BUFFERS];
+    int queueHead, queueCount;
+    unsigned char* encoded;          // Writer's scratch for PNG data
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_t writer;
+    bool stopping;
+    unsigned long written, dropped, failed;
+} FrameExporter;
+
+bool parseFrameFormat(const char* text, int* format);
+bool startFrameExport(FrameExporter* exporter, const char* directory, int format, int width, int height);
+int acquireExportBuffer(FrameExporter* exporter);
+void submitExportFrame(FrameExporter* exporter, int buffer, unsigned long frameNumber);
+void releaseExportBuffer(FrameExporter* exporter, int buffer);
+void stopFrameExport(FrameExporter* exporter);
+
+#endif
@@ -0,0 +1,114 @@
+#include "heatmap.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+bool initHeatmap(Heatmap* heatmap, SDL_Renderer* renderer, Junction* junction) {
+    memset(heatmap, 0, sizeof(*heatmap));
+    heatmap->ticksPerSecond = junctionTicksPerSecond(junction);
+    heatmap->laneWidth = junctionLaneWidth(junction);
+    heatmap->tick = junctionTick(junction);
+    heatmap->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                         SNAPSHOT_GRID, SNAPSHOT_GRID);
+    if (!heatmap->texture) {
+        printf("Failed to create heatmap texture: %s\n", SDL_GetError());
+        return false;
+    }
+    // Blended over the roads and smoothed between cells when stretched
+    SDL_SetTextureBlendMode(heatmap->texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(heatmap->texture, SDL_ScaleModeLinear);
+    heatmap->dirty = true;
+    return true;
+}
+
+void freeHeatmap(Heatmap* heatmap) {
+    if (heatmap->texture) SDL_DestroyTexture(heatmap->texture);
+    heatmap->texture = NULL;
+}
+
+// Where the k-th vehicle waiting in a lane stands: k + 1/2 places back from
+// the stop line, in the lane's own direction of travel
+static void queuePlace(const Heatmap* heatmap, int road, int lane, int k, float* x, float* y) {
+    float center = JUNCTION_WORLD_SIZE / 2;
+    float half = heatmap->laneWidth * JUNCTION_LANES_PER_ROAD / 2.0f;
+    float laneOffset = heatmap->laneWidth * lane + heatmap->laneWidth / 2.0f;
+    float back = (k + 0.5f) * HEATMAP_QUEUE_SPACING;
+    switch (road) {
+        case 0: *x = center - half + laneOffset; *y = center + half + back; break; // A, from the bottom
+        case 1: *x = center + half - laneOffset; *y = center - half - back; break; // B, from the top
+        case 2: *x = center + half + back; *y = center - half + laneOffset; break; // C, from the right
+        default: *x = center - half - back; *y = center + half - laneOffset; break; // D, from the left
+    }
+}
+
+// Adds or removes the queue places between the old and new length of one
+// lane; places past the edge of the world are not counted
+static void moveQueue(Heatmap* heatmap, int road, int lane, int count) {
+    int before = heatmap->laneCounts[road][lane];
+    heatmap->laneCounts[road][lane] = count;
+    int from = before < count ? before : count;
+    int to = before < count ? count : before;
+    int delta = before < count ? 1 : -1;
+    if (to > HEATMAP_QUEUE_SLOTS) to = HEATMAP_QUEUE_SLOTS;
+    for (int k = from; k < to; k++) {
+        float x, y;
+        queuePlace(heatmap, road, lane, k, &x, &y);
+        if (x < 0 || y < 0 || x >= JUNCTION_WORLD_SIZE || y >= JUNCTION_WORLD_SIZE) break;
+        heatmap->queued[snapshotCell(y) * SNAPSHOT_GRID + snapshotCell(x)] += delta;
+    }
+}
+
+// Yellow for light traffic through to red for a cell at HEATMAP_FULL,
+// transparent where nothing has been
+static Uint32 heatColor(float heat) {
+    float level = heat / HEATMAP_FULL;
+    if (level > 1.0f) level = 1.0f;
+    Uint32 alpha = (Uint32)(level * HEATMAP_MAX_ALPHA + 0.5f);
+    Uint32 green = (Uint32)((1.0f - level) * 220 + 0.5f);
+    return alpha << 24 | 255u << 16 | green << 8;
+}
+
+// Folds a new snapshot into the heat. Old heat decays by how much simulated
+// time passed since the last one, so the picture fades at the same rate at
+// any time compression.
+void updateHeatmap(Heatmap* heatmap, const SimSnapshot* snapshot) {
+    if (snapshot->tick == heatmap->tick) return;
+    double decay = 0.0;  // A snapshot from before the last one starts the picture afresh
+    if (snapshot->tick > heatmap->tick) {
+        double seconds = (double)(snapshot->tick - heatmap->tick) / heatmap->ticksPerSecond;
+        decay = pow(0.5, seconds / HEATMAP_HALF_LIFE);
+    }
+    heatmap->tick = snapshot->tick;
+
+    for (int road = 0; road < JUNCTION_ROADS; road++) {
+        for (int lane = 0; lane < JUNCTION_LANES_PER_ROAD; lane++) {
+            if (snapshot->laneCounts[road][lane] != heatmap->laneCounts[road][lane]) {
+                moveQueue(heatmap, road, lane, snapshot->laneCounts[road][lane]);
+            }
+        }
+    }
+
+    float keep = (float)decay;
+    for (int c = 0; c < HEATMAP_CELLS; c++) {
+        int vehicles = snapshot->cellStart[c + 1] - snapshot->cellStart[c] + heatmap->queued[c];
+        heatmap->heat[c] = heatmap->heat[c] * keep + vehicles * (1.0f - keep);
+        heatmap->pixels[c] = heatColor(heatmap->heat[c]);
+    }
+    heatmap->dirty = true;
+}
+
+// Uploads the grid if it changed and stretches it over the whole world
+void drawHeatmap(Heatmap* heatmap, SDL_Renderer* renderer, const Camera* camera) {
+    if (heatmap->dirty) {
+        if (SDL_UpdateTexture(heatmap->texture, NULL, heatmap->pixels, SNAPSHOT_GRID * sizeof(Uint32)) != 0) {
+            printf("Failed to update heatmap: %s\n", SDL_GetError());
+        }
+        heatmap->dirty = false;
+    }
+    if (!cameraSees(camera, 0, 0, JUNCTION_WORLD_SIZE, JUNCTION_WORLD_SIZE)) return;
+    float left, top, right, bottom;
+    cameraToScreen(camera, 0, 0, &left, &top);
+    cameraToScreen(camera, JUNCTION_WORLD_SIZE, JUNCTION_WORLD_SIZE, &right, &bottom);
+    SDL_FRect target = {left, top, right - left, bottom - top};
+    SDL_RenderCopyF(renderer, heatmap->texture, NULL, &target);
+}
@@ -0,0 +1,39 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "junction.h"
+#include "snapshot.h"
+#include "camera.h"
+
+#define HEATMAP_CELLS (SNAPSHOT_GRID * SNAPSHOT_GRID)
+#define HEATMAP_HALF_LIFE 10.0       // Simulated seconds for old congestion to fade by half
+#define HEATMAP_FULL 3.0f            // Vehicles in a cell for the strongest colour
+#define HEATMAP_MAX_ALPHA 170        // Opacity of the strongest colour, roads stay visible under it
+#define HEATMAP_QUEUE_SPACING 35     // World units each queued vehicle takes behind the stop line
+#define HEATMAP_QUEUE_SLOTS (JUNCTION_WORLD_SIZE / 2 / HEATMAP_QUEUE_SPACING) // Queue places on screen per lane
+
+// Congestion over time on the snapshot grid, one texel per cell. Vehicles
+// in flight are counted from the snapshot's cell offsets; queued vehicles
+// have no position, so each lane's queue is laid out behind its stop line
+// and only the places that filled or emptied since the last snapshot are
+// touched. Heat is a moving average with exponential decay, so each frame
+// costs the same fixed pass over the grid however many vehicles there are.
+typedef struct {
+    SDL_Texture* texture;        // Streaming, SNAPSHOT_GRID texels per side
+    float heat[HEATMAP_CELLS];   // Average vehicles per cell
+    int queued[HEATMAP_CELLS];   // Queued vehicles per cell at laneCounts
+    int laneCounts[JUNCTION_ROADS][JUNCTION_LANES_PER_ROAD];
+    Uint32 pixels[HEATMAP_CELLS];
+    unsigned long long tick;     // Snapshot the heat was last updated from
+    int ticksPerSecond;
+    int laneWidth;
+    bool dirty;                  // Pixels changed since the last upload
+} Heatmap;
+
+bool initHeatmap(Heatmap* heatmap, SDL_Renderer* renderer, Junction* junction);
+void freeHeatmap(Heatmap* heatmap);
+void updateHeatmap(Heatmap* heatmap, const SimSnapshot* snapshot);
+void drawHeatmap(Heatmap* heatmap, SDL_Renderer* renderer, const Camera* camera);
+
+#endif
@@ -0,0 +1,310 @@
+#include "ingest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define INGEST_X86 1
+#endif
+
+#define FEED_BATCH 64  // Plates handed to junctionSubmitArrivals at once
+
+typedef struct {
+    char text[JUNCTION_PLATE_SIZE + 1];
+} PlateRecord;
+
+// One worker's share of the input and the plates it found, per road
+typedef struct {
+    const char* begin;
+    const char* end;
+    PlateRecord* plates[JUNCTION_ROADS];
+    int counts[JUNCTION_ROADS];
+    int capacities[JUNCTION_ROADS];
+    size_t rejected;  // Lines that were not a valid "PLATE:ROAD"
+    bool failed;
+} IngestShard;
+
+// Submits one road's plates from every shard, in shard order
+typedef struct {
+    Junction* junction;
+    IngestShard* shards;
+    int shardCount;
+    int road;
+    unsigned int* seed;  // This road's lane picks
+    int submitted;
+} RoadFeed;
+
+// Byte classes for the line decoder, so a line is checked with table
+// lookups rather than library calls
+#define BYTE_PLATE 1   // May appear in a plate
+static unsigned char byteClass[256];
+static signed char roadOfLetter[256];
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT;
+
+static void buildTables(void) {
+    for (int c = 0; c < 256; c++) {
+        bool plate = (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+        byteClass[c] = plate ? BYTE_PLATE : 0;
+        roadOfLetter[c] = -1;
+    }
+    for (int road = 0; road < JUNCTION_ROADS; road++) roadOfLetter['A' + road] = (signed char)road;
+}
+
+// Road letter to road index, -1 if it is not one
+int ingestRoadIndex(const char* roadName) {
+    pthread_once(&tablesOnce, buildTables);
+    if (roadName[0] == '\0' || roadName[1] != '\0') return -1;
+    return roadOfLetter[(unsigned char)roadName[0]];
+}
+
+static bool addPlate(IngestShard* shard, int road, const char* plate, int length) {
+    if (shard->counts[road] == shard->capacities[road]) {
+        int newCapacity = shard->capacities[road] > 0 ? shard->capacities[road] * 2 : 256;
+        PlateRecord* grown = (PlateRecord*)realloc(shard->plates[road], sizeof(PlateRecord) * newCapacity);
+        if (grown == NULL) {
+            printf("Error: could not grow ingest shard to %d vehicles\n", newCapacity);
+            return false;
+        }
+        shard->plates[road] = grown;
+        shard->capacities[road] = newCapacity;
+    }
+    PlateRecord* record = &shard->plates[road][shard->counts[road]++];
+    memcpy(record->text, plate, length);
+    record->text[length] = '\0';
+    return true;
+}
+
+// One line without its newline. The road is always the last character
+// and the separator the one before it, so the line is decoded from its
+// end with no search: "AB1CD234:A" or "AB1CD234:A\r".
+static inline bool decodeLine(IngestShard* shard, const char* line, const char* end) {
+    if (end > line && end[-1] == '\r') end--;
+    if (end == line) return true;  // Blank line
+    int length = (int)(end - line) - 2;  // Plate characters
+    if (length < 1 || length > JUNCTION_PLATE_SIZE || end[-2] != ':') {
+        shard->rejected++;
+        return true;
+    }
+    int road = roadOfLetter[(unsigned char)end[-1]];
+    unsigned char valid = BYTE_PLATE;
+    for (int i = 0; i < length; i++) valid &= byteClass[(unsigned char)line[i]];
+    if (road < 0 || !valid) {
+        shard->rejected++;
+        return true;
+    }
+    return addPlate(shard, road, line, length);
+}
+
+// Newline positions come from comparing 16 or 32 bytes at once; each set
+// bit in the mask ends a line. Lines are decoded in order as bits are taken.
+#define SCAN_MASK(mask, base)                                              \
+    while (mask) {                                                         \
+        const char* newline = (base) + __builtin_ctz(mask);                \
+        if (!decodeLine(shard, line, newline)) return false;               \
+        line = newline + 1;                                                \
+        mask &= mask - 1;                                                  \
+    }
+
+static bool scanScalar(IngestShard* shard, const char* line, const char* from, const char* end) {
+    for (const char* p = from; p < end; p++) {
+        if (*p != '\n') continue;
+        if (!decodeLine(shard, line, p)) return false;
+        line = p + 1;
+    }
+    if (line < end && !decodeLine(shard, line, end)) return false;
+    return true;
+}
+
+#ifdef INGEST_X86
+static bool scanSse2(IngestShard* shard) {
+    const char* line = shard->begin;
+    const char* p = shard->begin;
+    const __m128i newlines = _mm_set1_epi8('\n');
+    for (; shard->end - p >= 16; p += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)p);
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newlines));
+        SCAN_MASK(mask, p)
+    }
+    return scanScalar(shard, line, p, shard->end);
+}
+
+__attribute__((target("avx2")))
+static bool scanAvx2(IngestShard* shard) {
+    const char* line = shard->begin;
+    const char* p = shard->begin;
+    const __m256i newlines = _mm256_set1_epi8('\n');
+    for (; shard->end - p >= 32; p += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)p);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newlines));
+        SCAN_MASK(mask, p)
+    }
+    return scanScalar(shard, line, p, shard->end);
+}
+#endif
+
+static void* parseShard(void* arg) {
+    IngestShard* shard = (IngestShard*)arg;
+    bool ok;
+#ifdef INGEST_X86
+    if (__builtin_cpu_supports("avx2")) ok = scanAvx2(shard);
+    else ok = scanSse2(shard);
+#else
+    ok = scanScalar(shard, shard->begin, shard->begin, shard->end);
+#endif
+    if (!ok) shard->failed = true;
+    return NULL;
+}
+
+static void* feedRoad(void* arg) {
+    RoadFeed* feed = (RoadFeed*)arg;
+    const char* batch[FEED_BATCH];
+    for (int i = 0; i < feed->shardCount; i++) {
+        IngestShard* shard = &feed->shards[i];
+        int count = shard->counts[feed->road];
+        for (int first = 0; first < count; first += FEED_BATCH) {
+            int size = count - first < FEED_BATCH ? count - first : FEED_BATCH;
+            for (int k = 0; k < size; k++) batch[k] = shard->plates[feed->road][first + k].text;
+            feed->submitted += junctionSubmitArrivals(feed->junction, feed->road, batch, size, feed->seed);
+        }
+    }
+    return NULL;
+}
+
+void initIngestSeeds(unsigned int seeds[JUNCTION_ROADS]) {
+    for (int road = 0; road < JUNCTION_ROADS; road++) seeds[road] = INGEST_SEED + (unsigned int)road;
+}
+
+int ingestVehicleLines(Junction* junction, const char* text, size_t length, int workers,
+                       unsigned int seeds[JUNCTION_ROADS]) {
+    if (length == 0) return 0;
+    pthread_once(&tablesOnce, buildTables);
+
+    // Small inputs are not worth a thread
+    size_t byLength = length / INGEST_MIN_SHARD + 1;
+    if (workers < 1) workers = 1;
+    if (workers > INGEST_MAX_WORKERS) workers = INGEST_MAX_WORKERS;
+    if ((size_t)workers > byLength) workers = (int)byLength;
+
+    IngestShard shards[INGEST_MAX_WORKERS];
+    memset(shards, 0, sizeof(shards));
+
+    // Cut into roughly equal shards, each ending just after a newline
+    const char* end = text + length;
+    const char* begin = text;
+    int shardCount = 0;
+    for (int i = 0; i < workers && begin < end; i++) {
+        const char* cut = i + 1 == workers ? end : text + length / workers * (i + 1);
+        if (cut < begin) cut = begin;
+        if (cut < end) {
+            const char* newline = memchr(cut, '\n', end - cut);
+            cut = newline ? newline + 1 : end;
+        }
+        shards[shardCount].begin = begin;
+        shards[shardCount].end = cut;
+        shardCount++;
+        begin = cut;
+    }
+
+    // Parse: shard 0 on this thread, the rest in parallel
+    pthread_t threads[INGEST_MAX_WORKERS];
+    bool started[INGEST_MAX_WORKERS] = {false};
+    for (int i = 1; i < shardCount; i++) {
+        started[i] = pthread_create(&threads[i], NULL, parseShard, &shards[i]) == 0;
+        if (!started[i]) parseShard(&shards[i]);
+    }
+    parseShard(&shards[0]);
+    for (int i = 1; i < shardCount; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+
+    // Submit: one thread per road, each taking the shards in order
+    JunctionStats before, after;
+    junctionGetStats(junction, &before);
+    RoadFeed feeds[JUNCTION_ROADS];
+    pthread_t feeders[JUNCTION_ROADS];
+    bool feeding[JUNCTION_ROADS] = {false};
+    for (int road = 0; road < JUNCTION_ROADS; road++) {
+        feeds[road] = (RoadFeed){junction, shards, shardCount, road, &seeds[road], 0};
+        if (shardCount > 1) {
+            feeding[road] = pthread_create(&feeders[road], NULL, feedRoad, &feeds[road]) == 0;
+        }
+        if (!feeding[road]) feedRoad(&feeds[road]);
+    }
+    int submitted = 0;
+    size_t rejected = 0;
+    for (int road = 0; road < JUNCTION_ROADS; road++) {
+        if (feeding[road]) pthread_join(feeders[road], NULL);
+        submitted += feeds[road].submitted;
+    }
+
+    for (int i = 0; i < shardCount; i++) {
+        if (shards[i].failed) printf("Warning: some vehicles in ingest shard %d were not parsed\n", i);
+        rejected += shards[i].rejected;
+        for (int road = 0; road < JUNCTION_ROADS; road++) free(shards[i].plates[road]);
+    }
+    if (rejected > 0) printf("Warning: skipped %zu malformed vehicle lines\n", rejected);
+    junctionGetStats(junction, &after);
+    if (after.unrouted > before.unrouted) {
+        printf("Warning: dropped %llu vehicles on lanes with no turns, %llu in total\n",
+               after.unrouted - before.unrouted, after.unrouted);
+    }
+    return submitted;
+}
+
+// Removes the first `taken` bytes of the file, keeping anything after them,
+// including lines appended while the backlog was being ingested
+static void dropConsumed(const char* path, long taken) {
+    FILE* file = fopen(path, "r");
+    FILE* tempFile = fopen(path, "r+");
+    if (file && tempFile) {
+        fseek(file, taken, SEEK_SET);
+        char buffer[4096];
+        long newPos = 0;
+        size_t chunk;
+        while ((chunk = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            fseek(tempFile, newPos, SEEK_SET);
+            fwrite(buffer, 1, chunk, tempFile);
+            newPos += (long)chunk;
+        }
+        fflush(tempFile);
+        if (ftruncate(fileno(tempFile), newPos) != 0) perror("Error truncating vehicle file");
+    }
+    if (file) fclose(file);
+    if (tempFile) fclose(tempFile);
+}
+
+// Maps the file instead of reading it, so a large backlog is scanned
+// straight out of the page cache with no copy
+int ingestVehicleFile(Junction* junction, const char* path, int workers, unsigned int seeds[JUNCTION_ROADS]) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)info.st_size;
+    const char* text = (const char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        perror("Error mapping vehicle file");
+        return 0;
+    }
+    madvise((void*)text, size, MADV_SEQUENTIAL);
+
+    // Only whole lines are taken; a line still being written stays for next time
+    size_t taken = size;
+    while (taken > 0 && text[taken - 1] != '\n') taken--;
+    int count = ingestVehicleLines(junction, text, taken, workers, seeds);
+    munmap((void*)text, size);
+
+    if (taken > 0) dropConsumed(path, (long)taken);
+    return count;
+}
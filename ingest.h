@@ -0,0 +1,31 @@
+#ifndef INGEST_H
+#define INGEST_H
+#include <stddef.h>
+#include "junction.h"
+
+#define INGEST_MAX_WORKERS 32
+#define INGEST_MIN_SHARD (64 * 1024)  // Bytes of input per parser before another one is worth starting
+#define INGEST_SEED 0x4A4E4354u       // Road r's lane picks start from INGEST_SEED + r
+
+// Parses "PLATE:ROAD" lines and submits them to the junction. The text is
+// split at line boundaries into one shard per worker and the shards are
+// scanned in parallel, 16 or 32 bytes at a time (SSE2 or AVX2, whichever
+// the CPU has; plain C elsewhere). Each road's vehicles are then submitted
+// by a thread of their own, shard by shard, so every road sees its
+// vehicles in input order. Plates must be 1 to 8 capital letters or
+// digits; other lines are skipped. Vehicles that draw a lane with no turns
+// are reported once at the end. Returns the number of vehicles submitted.
+//
+// Each road's feeder draws lanes from its own seed in `seeds`, kept by the
+// caller from one ingest to the next, so the same input always gets the
+// same lanes however the threads are scheduled.
+int ingestVehicleLines(Junction* junction, const char* text, size_t length, int workers,
+                       unsigned int seeds[JUNCTION_ROADS]);
+
+// Ingests every complete line of the file and removes them from it.
+// Returns -1 if the file does not exist.
+int ingestVehicleFile(Junction* junction, const char* path, int workers, unsigned int seeds[JUNCTION_ROADS]);
+void initIngestSeeds(unsigned int seeds[JUNCTION_ROADS]);
+int ingestRoadIndex(const char* roadName);
+
+#endif
@@ -0,0 +1,731 @@
+#include "junction.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "dataManagement.h"
+#include "activeSet.h"
+#include "threadPool.h"
+#include "laneScheduler.h"
+#include "checkpoint.h"
+#include "replayLog.h"
+#include "vehicleIndex.h"
+#include "route.h"
+#include "routing.h"
+#include "sharedState.h"
+
+_Static_assert(JUNCTION_ROADS == MAX_ROADS, "public road count must match the model");
+_Static_assert(JUNCTION_LANES_PER_ROAD == MAX_LANE_SIZE, "public lane count must match the model");
+_Static_assert(JUNCTION_PLATE_SIZE == PLATE_SIZE, "public plate size must match the model");
+_Static_assert(SCENARIO_ROADS == MAX_ROADS && SCENARIO_LANES_PER_ROAD == MAX_LANE_SIZE,
+               "scenario tables must match the model");
+_Static_assert(SHARED_STATE_ROADS == MAX_ROADS && SHARED_STATE_LANES_PER_ROAD == MAX_LANE_SIZE &&
+               SHARED_STATE_PLATE_SIZE == PLATE_SIZE, "shared state layout must match the model");
+
+#define VEHICLE_SPEED 120 // World units per simulated second
+#define SUBMIT_BATCH_SIZE 64 // Arrivals staged per lock by junctionSubmitArrivals
+
+struct Junction {
+    Road* roads[MAX_ROADS];
+    ActiveSet active;
+    ArrivalStaging staging[MAX_ROADS]; // Arrivals from other threads, one shard per road
+    ThreadPool pool;
+    LaneScheduler scheduler;
+    VehicleIndex index;    // Plate ID to lane queue slot or active set index
+    WaitHistogram laneWaits[LANE_SLOTS]; // Queue wait of every released vehicle, per lane
+    RouteTable routes;     // Every lane-to-lane path, built once
+    ScenarioRouting routing; // Arrival lanes and turning ratios
+    RoutingTable nextHops; // Cheapest turn per origin and destination road
+    int laneWidth;
+    SignalPlan plan;
+    JunctionStats stats;
+    atomic_ullong unrouted; // Counted by the submitting threads, copied into stats when read
+    int ticksPerSecond;
+    bool fixedPoint;       // Move vehicles with the integer routes
+    unsigned long long tick;
+    int currentLight;
+    int nextLight;
+    bool trafficLightStatus[MAX_ROADS];
+
+    ReplayLog log;
+    bool recording;
+    bool replaying;
+
+    CheckpointWriter writer;
+    bool checkpointing;
+    unsigned long long checkpointTicks;
+
+    SharedStatePublisher shared;
+    bool sharing;
+
+    Vehicle* mergeBuffer;  // Arrivals swapped out of staging this step
+    int mergeCapacity;
+};
+
+static void applyScenario(JunctionConfig* config, const Scenario* scenario) {
+    config->laneWidth = scenario->laneWidth;
+    config->ticksPerSecond = scenario->ticksPerSecond;
+    config->plan = scenario->plan;
+    config->priorityLanes = scenario->priorityLanes;
+    config->promoteThreshold = scenario->promoteThreshold;
+    config->routing = scenario->routing;
+}
+
+void junctionDefaultConfig(JunctionConfig* config) {
+    memset(config, 0, sizeof(*config)); // No admission limits
+    Scenario scenario;
+    defaultScenario(&scenario);
+    applyScenario(config, &scenario);
+}
+
+bool junctionLoadScenario(const char* path, JunctionConfig* config) {
+    Scenario scenario;
+    if (!loadScenario(path, &scenario)) return false;
+    applyScenario(config, &scenario);
+    return true;
+}
+
+// Lane list such as "A2,C1" to the priorityLanes bitmask
+bool junctionParseLanes(const char* text, unsigned int* mask) {
+    return parseLaneList(text, mask);
+}
+
+Junction* junctionCreate(const JunctionConfig* config) {
+    if (config->laneWidth < SCENARIO_MIN_LANE_WIDTH || config->laneWidth > SCENARIO_MAX_LANE_WIDTH ||
+        config->laneWidth % 2 != 0) {
+        printf("Error: lane width %d is not an even number from %d to %d\n", config->laneWidth,
+               SCENARIO_MIN_LANE_WIDTH, SCENARIO_MAX_LANE_WIDTH);
+        return NULL;
+    }
+    // The staging shards and worker deques inside are cache-line aligned
+    Junction* junction = aligned_alloc(CACHE_LINE_SIZE, sizeof(Junction));
+    if (junction == NULL) {
+        printf("Error: could not allocate junction\n");
+        return NULL;
+    }
+    memset(junction, 0, sizeof(Junction));
+    AdmissionPolicy policy = {config->maxActive, config->maxReleasePerTick};
+    if (!initActiveSet(&junction->active, ACTIVE_SET_INITIAL_CAPACITY, policy)) {
+        free(junction);
+        return NULL;
+    }
+    if (!initVehicleIndex(&junction->index, VEHICLE_INDEX_INITIAL_CAPACITY)) {
+        freeActiveSet(&junction->active);
+        free(junction);
+        return NULL;
+    }
+    for (int i = 0; i < MAX_ROADS; i++) initArrivalStaging(&junction->staging[i]);
+    initThreadPool(&junction->pool, config->workerThreads > 0 ? config->workerThreads : defaultWorkerCount());
+    initializeRoads(junction->roads);
+    markPriorityLanes(junction->roads, config->priorityLanes);
+    initLaneScheduler(&junction->scheduler, config->promoteThreshold);
+    buildRouteTable(&junction->routes, config->laneWidth);
+    buildRoutingTable(&junction->nextHops, &config->routing, &junction->routes);
+    for (int i = 0; i < LANE_SLOTS; i++) initWaitHistogram(&junction->laneWaits[i]);
+
+    junction->plan = config->plan;
+    junction->routing = config->routing;
+    junction->laneWidth = config->laneWidth;
+    junction->fixedPoint = config->fixedPoint;
+    junction->ticksPerSecond = config->ticksPerSecond > 0 ? config->ticksPerSecond : JUNCTION_DEFAULT_TICKS_PER_SECOND;
+    return junction;
+}
+
+void junctionDestroy(Junction* junction) {
+    if (junction == NULL) return;
+    if (junction->checkpointing) stopCheckpointWriter(&junction->writer);
+    if (junction->sharing) closeSharedStatePublisher(&junction->shared);
+    closeReplayLog(&junction->log);
+    destroyThreadPool(&junction->pool);
+    for (int i = 0; i < MAX_ROADS; i++) freeArrivalStaging(&junction->staging[i]);
+    freeActiveSet(&junction->active);
+    freeVehicleIndex(&junction->index);
+    freeRoads(junction->roads);
+    free(junction->mergeBuffer);
+    free(junction);
+}
+
+static VehicleLocation queuedAt(int road, int lane, int ring) {
+    return (VehicleLocation){VEHICLE_QUEUED, (signed char)road, (signed char)lane, ring};
+}
+
+static VehicleLocation inFlightAt(int index) {
+    return (VehicleLocation){VEHICLE_IN_FLIGHT, -1, -1, index};
+}
+
+static const VehicleLocation nowhere = {VEHICLE_NOWHERE, -1, -1, -1};
+
+// Puts a released vehicle at the start of its lane, heading for the junction.
+// Returns false when the admission policy is full or memory ran out;
+// the caller keeps ownership of the vehicle in that case.
+static bool admitVehicle(Junction* junction, Vehicle vehicle) {
+    if (!activeSetCanAdmit(&junction->active)) return false;
+
+    int road, lane, destRoad, destLane;
+    laneToIndex(junction->roads, vehicle.currentLane, &road, &lane);
+    laneToIndex(junction->roads, vehicle.destinationLane, &destRoad, &destLane);
+    if (road < 0 || destRoad < 0) return false;
+
+    VehicleUI* vui = activeSetAdd(&junction->active);
+    if (vui == NULL) return false;
+    vui->vehicle = vehicle;
+
+    // Start at the beginning of the route from its lane to its destination
+    vui->route = routeIndex(road, lane, destRoad, destLane);
+    vui->distance = 0;
+    vui->fixedDistance = 0;
+    if (junction->fixedPoint) {
+        int32_t x, y;
+        fixedRoutePosition(&junction->routes.fixed[vui->route], 0, &x, &y);
+        vui->x = (float)x / ROUTE_FIXED_ONE;
+        vui->y = (float)y / ROUTE_FIXED_ONE;
+    } else {
+        routePosition(&junction->routes.routes[vui->route], 0, &vui->x, &vui->y);
+    }
+    vui->prevX = vui->x;
+    vui->prevY = vui->y;
+    vui->isMoving = true;
+    vui->hasArrived = false;
+    return true;
+}
+
+// Shared state for one parallel update pass
+typedef struct {
+    Junction* junction;
+    float stepDistance;  // How far a vehicle moves in one tick
+    int32_t fixedStep;   // The same in fixed-point units
+    atomic_int arrivedCount;
+} UpdateJob;
+
+// Moves vehicles [begin, end). Each vehicle is touched by exactly one worker
+// and arrivals are only flagged here; removal happens after the pass.
+static void updateVehicleRange(void* context, int begin, int end) {
+    UpdateJob* job = (UpdateJob*)context;
+    ActiveSet* active = &job->junction->active;
+    int arrived = 0;
+
+    for (int i = begin; i < end; i++) {
+        VehicleUI* vui = &active->vehicles[i];
+        vui->prevX = vui->x;
+        vui->prevY = vui->y;
+        if (!vui->isMoving || vui->hasArrived) continue;
+
+        if (job->junction->fixedPoint) {
+            // Integer only: the same on every compiler and optimisation level.
+            // Float positions are the exact value of the fixed-point ones.
+            const FixedRoute* route = &job->junction->routes.fixed[vui->route];
+            int32_t x, y;
+            vui->fixedDistance += job->fixedStep;
+            if (vui->fixedDistance >= route->length) {
+                vui->fixedDistance = route->length;
+                vui->hasArrived = true;
+                vui->isMoving = false;
+                arrived++;
+            }
+            fixedRoutePosition(route, vui->fixedDistance, &x, &y);
+            vui->x = (float)x / ROUTE_FIXED_ONE;
+            vui->y = (float)y / ROUTE_FIXED_ONE;
+            vui->distance = (float)vui->fixedDistance / ROUTE_FIXED_ONE;
+            continue;
+        }
+
+        // Advance along the route; the position is a table lookup
+        const Route* route = &job->junction->routes.routes[vui->route];
+        vui->distance += job->stepDistance;
+        if (vui->distance >= route->length) {
+            vui->distance = route->length;
+            vui->hasArrived = true;
+            vui->isMoving = false;
+            arrived++;
+        }
+        routePosition(route, vui->distance, &vui->x, &vui->y);
+    }
+    if (arrived > 0) atomic_fetch_add(&job->arrivedCount, arrived);
+}
+
+static void updateVehiclesPosition(Junction* junction) {
+    UpdateJob job;
+    job.junction = junction;
+    job.stepDistance = (float)VEHICLE_SPEED / junction->ticksPerSecond;
+    job.fixedStep = (VEHICLE_SPEED * ROUTE_FIXED_ONE + junction->ticksPerSecond / 2) / junction->ticksPerSecond;
+    atomic_init(&job.arrivedCount, 0);
+
+    threadPoolParallelFor(&junction->pool, junction->active.count, THREAD_POOL_DEFAULT_CHUNK,
+                          updateVehicleRange, &job);
+
+    // Clean up vehicles that have reached their destination
+    if (atomic_load(&job.arrivedCount) == 0) return;
+    int i = 0;
+    while (i < junction->active.count) {
+        if (junction->active.vehicles[i].hasArrived) {
+            // Swap-remove: the last vehicle moves into slot i, so check i again
+            int last = junction->active.count - 1;
+            vehicleIndexMove(&junction->index, junction->active.vehicles[i].vehicle.id, inFlightAt(i), nowhere);
+            activeSetRemove(&junction->active, i);
+            if (i != last) {
+                vehicleIndexMove(&junction->index, junction->active.vehicles[i].vehicle.id,
+                                 inFlightAt(last), inFlightAt(i));
+            }
+            junction->stats.departed++;
+        } else {
+            i++;
+        }
+    }
+}
+
+// Moves one road's staged arrivals into their lane queues, in the order
+// they were staged. Returns how many found their lane full.
+static int mergeStagedRoad(Junction* junction, int road) {
+    int dropped = 0;
+    int count = swapStagedArrivals(&junction->staging[road], &junction->mergeBuffer, &junction->mergeCapacity);
+    for (int i = 0; i < count; i++) {
+        Vehicle vehicle = junction->mergeBuffer[i];
+        Lane* lane = vehicle.currentLane;
+        vehicle.arrivalTick = junction->tick;
+        if (junction->recording) recordArrival(&junction->log, junction->roads, junction->tick, &vehicle);
+        int ring = lane->queue.rear; // Slot the vehicle will occupy
+        if (enqueue(&lane->queue, vehicle)) {
+            int roadIndex, laneIndex;
+            laneToIndex(junction->roads, lane, &roadIndex, &laneIndex);
+            vehicleIndexInsert(&junction->index, vehicle.id, queuedAt(roadIndex, laneIndex, ring));
+            laneSchedulerUpdate(&junction->scheduler, roadIndex * MAX_LANE_SIZE + laneIndex,
+                                lane->queue.count, lane->isPriority);
+            junction->stats.arrived++;
+        } else {
+            junction->stats.dropped++;
+            dropped++;
+        }
+    }
+    return dropped;
+}
+
+// Moves arrivals staged by other threads into their lane queues, where
+// they wait for green. This is the point where an arrival becomes part of
+// the simulation, so it is also where arrivals are recorded.
+// Drops are reported once per tick, however large the backlog.
+static void mergeStagedArrivals(Junction* junction) {
+    int dropped = 0;
+    for (int road = 0; road < MAX_ROADS; road++) {
+        dropped += mergeStagedRoad(junction, road);
+    }
+    if (dropped > 0) {
+        printf("Error: %d vehicles dropped at full lanes in tick %llu, %llu in total\n",
+               dropped, junction->tick, junction->stats.dropped);
+    }
+}
+
+// Releases at most one vehicle per green lane this tick. Lanes are taken
+// from the scheduler, so priority lanes and lanes over the promotion
+// threshold go first when the admission policy cannot take everyone.
+static void processVehicleQueues(Junction* junction) {
+    int released = 0;
+    int maxRelease = junction->active.policy.maxReleasePerTick;
+    unsigned int eligible = 0;
+
+    for (int i = 0; i < MAX_ROADS; i++) {
+        if (junction->trafficLightStatus[i]) eligible |= roadLaneMask(i); // If green light
+    }
+
+    // Stop once the admission policy says the junction is full, or before
+    // taking a vehicle off its queue that the set has no room for
+    while (activeSetCanAdmit(&junction->active) && (maxRelease == 0 || released < maxRelease)) {
+        int slot = laneSchedulerNext(&junction->scheduler, eligible);
+        if (slot < 0 || !activeSetReserve(&junction->active, junction->active.count + 1)) break;
+        eligible &= ~(1u << slot);
+        Lane* lane = &junction->roads[slot / MAX_LANE_SIZE]->lanes[slot % MAX_LANE_SIZE];
+
+        pthread_mutex_lock(&lane->queue.mutex);
+        int ring = lane->queue.front;
+        Vehicle vehicle = dequeueLocked(&lane->queue);
+        vehicle.currentLane = lane;
+        laneSchedulerUpdate(&junction->scheduler, slot, lane->queue.count, lane->isPriority);
+        pthread_mutex_unlock(&lane->queue.mutex);
+        VehicleLocation queued = queuedAt(slot / MAX_LANE_SIZE, slot % MAX_LANE_SIZE, ring);
+        vehicle.releaseTick = junction->tick;
+        if (admitVehicle(junction, vehicle)) {
+            vehicleIndexMove(&junction->index, vehicle.id, queued, inFlightAt(junction->active.count - 1));
+            unsigned long long delay = junction->tick - vehicle.arrivalTick;
+            junction->stats.released++;
+            junction->stats.totalDelayTicks += delay;
+            if (delay > junction->stats.maxDelayTicks) junction->stats.maxDelayTicks = delay;
+            waitHistogramRecord(&junction->laneWaits[slot], delay);
+            released++;
+        } else {
+            // Only a vehicle with an unmapped lane gets here; it has left its
+            // queue, so it is counted as dropped to keep the totals balanced
+            vehicleIndexMove(&junction->index, vehicle.id, queued, nowhere);
+            junction->stats.dropped++;
+            printf("Error: vehicle %s has no route from lane %s and was dropped\n", vehicle.VechicleName, lane->laneName);
+        }
+    }
+}
+
+// Stages the recorded arrivals and light changes for this tick, in the
+// order they were recorded. Returns false once the log is exhausted.
+static bool feedReplay(Junction* junction) {
+    ReplayRecord record;
+    Vehicle vehicle;
+
+    while (nextReplayRecord(&junction->log, junction->tick, &record)) {
+        if (record.type == REPLAY_ARRIVAL) {
+            if (replayRecordToVehicle(junction->roads, &record, &vehicle)) {
+                int roadIndex, laneIndex;
+                laneToIndex(junction->roads, vehicle.currentLane, &roadIndex, &laneIndex);
+                stageArrival(&junction->staging[roadIndex], vehicle);
+            }
+        } else if (record.type == REPLAY_LIGHT_CHANGE) {
+            junction->nextLight = record.light;
+        }
+    }
+    return !replayFinished(&junction->log);
+}
+
+// Writes this tick into the next shared memory slot. Readers never hold a
+// lock, so this costs the copy and two atomic stores whoever is reading.
+static void publishJunctionState(Junction* junction) {
+    SharedStateSlot* slot = beginSharedStateWrite(&junction->shared);
+    slot->tick = junction->tick;
+    slot->greenRoad = junction->currentLight;
+    slot->flowing = 0;
+    for (int i = 0; i < MAX_ROADS; i++) {
+        if (junction->trafficLightStatus[i]) slot->flowing |= 1u << i;
+        for (int j = 0; j < MAX_LANE_SIZE; j++) slot->laneCounts[i][j] = junction->roads[i]->lanes[j].queue.count;
+    }
+    int capacity = junction->shared.header->vehicleCapacity;
+    slot->inFlight = junction->active.count;
+    slot->vehicleCount = junction->active.count < capacity ? junction->active.count : capacity;
+    for (int i = 0; i < slot->vehicleCount; i++) {
+        const VehicleUI* vui = &junction->active.vehicles[i];
+        SharedStateVehicle* out = &slot->vehicles[i];
+        int road, lane, destRoad, destLane;
+        laneToIndex(junction->roads, vui->vehicle.currentLane, &road, &lane);
+        laneToIndex(junction->roads, vui->vehicle.destinationLane, &destRoad, &destLane);
+        out->id = vui->vehicle.id;
+        memset(out->plate, 0, SHARED_STATE_PLATE_SIZE);
+        memcpy(out->plate, vui->vehicle.VechicleName, strnlen(vui->vehicle.VechicleName, SHARED_STATE_PLATE_SIZE));
+        out->x = vui->x;
+        out->y = vui->y;
+        out->road = (unsigned char)road;
+        out->lane = (unsigned char)lane;
+        out->destRoad = (unsigned char)destRoad;
+        out->destLane = (unsigned char)destLane;
+        out->waitTicks = (unsigned int)(vui->vehicle.releaseTick - vui->vehicle.arrivalTick);
+    }
+    publishSharedState(&junction->shared, slot);
+}
+
+// One step of the world
+void junctionStep(Junction* junction) {
+    junction->tick++;
+
+    // A replay injects the recorded inputs for this tick; otherwise the
+    // signal plan decides which road is green
+    if (junction->replaying && !feedReplay(junction)) {
+        junction->replaying = false;
+        closeReplayLog(&junction->log);
+        printf("Replay finished at tick %llu\n", junction->tick);
+    }
+    if (!junction->replaying) {
+        junction->nextLight = signalPlanLight(&junction->plan, junction->tick, junction->ticksPerSecond);
+    }
+
+    // Bring in vehicles submitted since the last tick
+    mergeStagedArrivals(junction);
+
+    // Apply the light change; roads the signal plan does not control always flow
+    if (junction->nextLight != junction->currentLight) {
+        printf("Light of queue updated from %d to %d\n", junction->currentLight, junction->nextLight);
+        junction->currentLight = junction->nextLight;
+        if (junction->recording) recordLightChange(&junction->log, junction->tick, junction->currentLight);
+    }
+    for (int i = 0; i < MAX_ROADS; i++) {
+        junction->trafficLightStatus[i] = (junction->currentLight == i) || !signalPlanControls(&junction->plan, i);
+    }
+
+    // Process vehicle queues based on traffic lights
+    processVehicleQueues(junction);
+
+    // Update vehicle positions
+    updateVehiclesPosition(junction);
+
+    // Re-cost routes out of roads whose queues changed
+    updateRoutingTable(&junction->nextHops, junction->roads);
+
+    // Copy the world between ticks; the writer thread does the disk I/O
+    if (junction->checkpointing && junction->tick % junction->checkpointTicks == 0) {
+        JunctionStats stats;
+        junctionGetStats(junction, &stats);
+        if (captureCheckpoint(junction->writer.capture, junction->roads, &junction->active, junction->staging,
+                              junction->tick, junction->currentLight, junction->nextLight, &stats,
+                              junction->laneWaits)) {
+            submitCheckpoint(&junction->writer);
+        }
+    }
+
+    if (junction->sharing) publishJunctionState(junction);
+}
+
+// Fills in a new vehicle on a lane of `road` with a destination, both
+// drawn from the scenario's weights. Fails when that lane has no turns;
+// those vehicles are only counted, since a scenario may send many there.
+static bool prepareArrival(Junction* junction, const char* plate, int road, unsigned int* seed, Vehicle* vehicle) {
+    memset(vehicle, 0, sizeof(*vehicle));
+    setVehiclePlate(vehicle, plate);
+    vehicle->road = junction->roads[road];
+
+    int laneIndex = pickWeighted(&junction->routing.arrivalLane[road], seed);
+    if (laneIndex < 0) {
+        atomic_fetch_add_explicit(&junction->unrouted, 1, memory_order_relaxed);
+        return false;
+    }
+    vehicle->currentLane = &vehicle->road->lanes[laneIndex];
+    int destination = pickWeighted(&junction->routing.turn[road * MAX_LANE_SIZE + laneIndex], seed);
+    vehicle->destinationLane = destination < 0 ? NULL :
+        indexToLane(junction->roads, destination / MAX_LANE_SIZE, destination % MAX_LANE_SIZE);
+    if (vehicle->destinationLane == NULL) {
+        atomic_fetch_add_explicit(&junction->unrouted, 1, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+// New vehicle on a random lane of `road`, with a destination picked for it.
+// Fails when that lane has no destination.
+bool junctionSubmitArrival(Junction* junction, const char* plate, int road) {
+    if (road < 0 || road >= MAX_ROADS) return false;
+    Vehicle vehicle;
+    if (!prepareArrival(junction, plate, road, NULL, &vehicle)) return false;
+    return stageArrival(&junction->staging[road], vehicle);
+}
+
+// Many arrivals on one road, staged in order in batches. Returns how many
+// were staged.
+int junctionSubmitArrivals(Junction* junction, int road, const char* const plates[], int count, unsigned int* seed) {
+    if (road < 0 || road >= MAX_ROADS) return 0;
+    Vehicle batch[SUBMIT_BATCH_SIZE];
+    int staged = 0, filled = 0;
+    for (int i = 0; i < count; i++) {
+        if (prepareArrival(junction, plates[i], road, seed, &batch[filled])) filled++;
+        if (filled == SUBMIT_BATCH_SIZE || (i + 1 == count && filled > 0)) {
+            if (!stageArrivals(&junction->staging[road], batch, filled)) break;
+            staged += filled;
+            filled = 0;
+        }
+    }
+    return staged;
+}
+
+// New vehicle with its lane and destination chosen by the caller
+bool junctionSubmitVehicle(Junction* junction, const char* plate, int road, int lane, int destRoad, int destLane) {
+    Vehicle vehicle;
+    memset(&vehicle, 0, sizeof(vehicle));
+    setVehiclePlate(&vehicle, plate);
+    vehicle.currentLane = indexToLane(junction->roads, road, lane);
+    vehicle.destinationLane = indexToLane(junction->roads, destRoad, destLane);
+    if (vehicle.currentLane == NULL || vehicle.destinationLane == NULL) {
+        printf("Error: vehicle %s has an invalid lane\n", vehicle.VechicleName);
+        return false;
+    }
+    vehicle.road = vehicle.currentLane->road;
+    return stageArrival(&junction->staging[road], vehicle);
+}
+
+// Cheapest lanes from `road` out by `destRoad` as of the last step
+bool junctionRouteTrip(const Junction* junction, int road, int destRoad, int* lane, int* destLane) {
+    if (road < 0 || road >= MAX_ROADS || destRoad < 0 || destRoad >= MAX_ROADS) return false;
+    int from, to;
+    if (!lookupRoute(&junction->nextHops, road, destRoad, &from, &to)) return false;
+    *lane = from % MAX_LANE_SIZE;
+    *destLane = to % MAX_LANE_SIZE;
+    return true;
+}
+
+// New vehicle going from `road` to `destRoad` by the cheapest lanes.
+// Fails when the scenario has no turn between the two roads.
+bool junctionSubmitTrip(Junction* junction, const char* plate, int road, int destRoad) {
+    int lane, destLane;
+    if (!junctionRouteTrip(junction, road, destRoad, &lane, &destLane)) return false;
+    return junctionSubmitVehicle(junction, plate, road, lane, destRoad, destLane);
+}
+
+unsigned long long junctionTick(const Junction* junction) {
+    return junction->tick;
+}
+
+int junctionTicksPerSecond(const Junction* junction) {
+    return junction->ticksPerSecond;
+}
+
+double junctionSimSeconds(const Junction* junction) {
+    return (double)junction->tick / junction->ticksPerSecond;
+}
+
+int junctionGreenRoad(const Junction* junction) {
+    return junction->currentLight;
+}
+
+int junctionLaneWidth(const Junction* junction) {
+    return junction->laneWidth;
+}
+
+const char* junctionRoadName(const Junction* junction, int road) {
+    if (road < 0 || road >= MAX_ROADS) return NULL;
+    return junction->roads[road]->roadName;
+}
+
+int junctionQueueLength(const Junction* junction, int road, int lane) {
+    if (road < 0 || road >= MAX_ROADS || lane < 0 || lane >= MAX_LANE_SIZE) return 0;
+    return junction->roads[road]->lanes[lane].queue.count;
+}
+
+int junctionVehicleCount(const Junction* junction) {
+    return junction->active.count;
+}
+
+static void describeVehicle(const Junction* junction, const Vehicle* vehicle, JunctionVehicle* out) {
+    memcpy(out->plate, vehicle->VechicleName, sizeof(out->plate));
+    out->id = vehicle->id;
+    out->arrivalTick = vehicle->arrivalTick;
+    out->releaseTick = vehicle->releaseTick;
+    laneToIndex((Road**)junction->roads, vehicle->currentLane, &out->road, &out->lane);
+    laneToIndex((Road**)junction->roads, vehicle->destinationLane, &out->destRoad, &out->destLane);
+}
+
+// Copies up to `max` in-flight vehicles; returns how many were copied
+int junctionGetVehicles(const Junction* junction, JunctionVehicle* vehicles, int max) {
+    int count = junction->active.count < max ? junction->active.count : max;
+    for (int i = 0; i < count; i++) {
+        const VehicleUI* vui = &junction->active.vehicles[i];
+        JunctionVehicle* out = &vehicles[i];
+        describeVehicle(junction, &vui->vehicle, out);
+        out->prevX = vui->prevX;
+        out->prevY = vui->prevY;
+        out->x = vui->x;
+        out->y = vui->y;
+    }
+    return count;
+}
+
+void junctionGetStats(const Junction* junction, JunctionStats* stats) {
+    *stats = junction->stats;
+    stats->unrouted = atomic_load_explicit(&junction->unrouted, memory_order_relaxed);
+}
+
+// Merges the lane histograms covered by road/lane, -1 meaning all of them
+void junctionGetWaitHistogram(const Junction* junction, int road, int lane, WaitHistogram* histogram) {
+    initWaitHistogram(histogram);
+    for (int slot = 0; slot < LANE_SLOTS; slot++) {
+        if (road >= 0 && slot / MAX_LANE_SIZE != road) continue;
+        if (lane >= 0 && slot % MAX_LANE_SIZE != lane) continue;
+        waitHistogramMerge(histogram, &junction->laneWaits[slot]);
+    }
+}
+
+void junctionGetWaitStats(const Junction* junction, int road, int lane, JunctionWaitStats* stats) {
+    WaitHistogram histogram;
+    double tickSeconds = 1.0 / junction->ticksPerSecond;
+    junctionGetWaitHistogram(junction, road, lane, &histogram);
+    stats->count = histogram.count;
+    stats->mean = waitHistogramMean(&histogram) * tickSeconds;
+    stats->p50 = waitHistogramQuantile(&histogram, 0.50) * tickSeconds;
+    stats->p95 = waitHistogramQuantile(&histogram, 0.95) * tickSeconds;
+    stats->p99 = waitHistogramQuantile(&histogram, 0.99) * tickSeconds;
+    stats->max = histogram.max * tickSeconds;
+}
+
+unsigned long long junctionPlateId(const char* plate) {
+    return packPlate(plate);
+}
+
+// Returns where the vehicle with this plate ID is, filling in `lookup`
+int junctionFindVehicle(const Junction* junction, unsigned long long id, JunctionVehicleLookup* lookup) {
+    memset(lookup, 0, sizeof(*lookup));
+    const VehicleLocation* location = vehicleIndexFind(&junction->index, id);
+    if (location == NULL) return lookup->state = JUNCTION_NOT_FOUND;
+
+    if (location->where == VEHICLE_QUEUED) {
+        const VehicleQueue* queue = &junction->roads[location->road]->lanes[location->lane].queue;
+        describeVehicle(junction, &queue->vehicles[location->slot], &lookup->vehicle);
+        lookup->queuePosition = (location->slot - queue->front + QUEUE_SIZE) % QUEUE_SIZE;
+        return lookup->state = JUNCTION_QUEUED;
+    }
+    const VehicleUI* vui = &junction->active.vehicles[location->slot];
+    describeVehicle(junction, &vui->vehicle, &lookup->vehicle);
+    lookup->vehicle.prevX = vui->prevX;
+    lookup->vehicle.prevY = vui->prevY;
+    lookup->vehicle.x = vui->x;
+    lookup->vehicle.y = vui->y;
+    return lookup->state = JUNCTION_IN_FLIGHT;
+}
+
+// Indexes every queued and in-flight vehicle from scratch
+static void rebuildVehicleIndex(Junction* junction) {
+    clearVehicleIndex(&junction->index);
+    for (int r = 0; r < MAX_ROADS; r++) {
+        for (int l = 0; l < MAX_LANE_SIZE; l++) {
+            const VehicleQueue* queue = &junction->roads[r]->lanes[l].queue;
+            for (int k = 0; k < queue->count; k++) {
+                int ring = (queue->front + k) % QUEUE_SIZE;
+                vehicleIndexInsert(&junction->index, queue->vehicles[ring].id, queuedAt(r, l, ring));
+            }
+        }
+    }
+    for (int i = 0; i < junction->active.count; i++) {
+        vehicleIndexInsert(&junction->index, junction->active.vehicles[i].vehicle.id, inFlightAt(i));
+    }
+}
+
+// Resume where a checkpoint left off
+bool junctionRestore(Junction* junction, const char* path) {
+    CheckpointImage image;
+    initCheckpointImage(&image);
+    bool ok = loadCheckpoint(path, &image) &&
+              restoreCheckpoint(&image, junction->roads, &junction->active, junction->staging);
+    if (ok) {
+        junction->tick = image.tick;
+        junction->currentLight = image.currentLight;
+        junction->nextLight = image.nextLight;
+        junction->stats = image.stats;
+        atomic_store(&junction->unrouted, image.stats.unrouted);
+        memcpy(junction->laneWaits, image.laneWaits, sizeof(junction->laneWaits));
+        laneSchedulerRebuild(&junction->scheduler, junction->roads);
+        rebuildVehicleIndex(junction);
+        printf("Restored tick %llu: %d queued, %d staged, %d in flight\n",
+               image.tick, image.queuedCount, image.stagedCount, image.activeCount);
+    }
+    freeCheckpointImage(&image);
+    return ok;
+}
+
+bool junctionStartCheckpoints(Junction* junction, const char* path, int everySeconds) {
+    if (everySeconds <= 0 || !startCheckpointWriter(&junction->writer, path)) return false;
+    junction->checkpointTicks = (unsigned long long)everySeconds * junction->ticksPerSecond;
+    junction->checkpointing = true;
+    return true;
+}
+
+bool junctionStartSharedState(Junction* junction, const char* name, int maxVehicles) {
+    if (junction->sharing ||
+        !openSharedStatePublisher(&junction->shared, name, maxVehicles, junction->ticksPerSecond, junction->laneWidth)) {
+        return false;
+    }
+    junction->sharing = true;
+    return true;
+}
+
+bool junctionStartRecording(Junction* junction, const char* path) {
+    if (junction->replaying || !openReplayRecorder(&junction->log, path)) return false;
+    junction->recording = true;
+    return true;
+}
+
+bool junctionStartReplay(Junction* junction, const char* path) {
+    if (junction->recording || !openReplayPlayer(&junction->log, path)) return false;
+    junction->replaying = true;
+    return true;
+}
+
+bool junctionReplaying(const Junction* junction) {
+    return junction->replaying;
+}
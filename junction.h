@@ -0,0 +1,155 @@
+#ifndef JUNCTION_H
+#define JUNCTION_H
+#include <stdbool.h>
+
+// libjunction: the four-way junction model (roads, lane queues, signal
+// plan, routing and vehicle motion) with no SDL dependency. The viewer in
+// simulator.c is one client; anything else can link the library and drive
+// a junction in-process.
+//
+// Time: everything in the model is measured in simulated time. One step is
+// 1/ticksPerSecond simulated seconds however fast the caller steps it;
+// pacing against the wall clock is up to the caller (see simClock.h).
+//
+// Threading: junctionStep and every query must come from one thread.
+// The junctionSubmit* calls may be called from any thread; submitted
+// vehicles join their lane queue on the next step. Each road has its own
+// staging queue, so threads feeding different roads do not contend, and
+// vehicles from one thread keep their order within a road.
+
+#define JUNCTION_API_VERSION 10
+
+#define JUNCTION_ROADS 4           // A (bottom), B (top), C (right), D (left)
+#define JUNCTION_LANES_PER_ROAD 3
+#define JUNCTION_PLATE_SIZE 8
+#define JUNCTION_WORLD_SIZE 800    // Vehicle positions are in a square of this size
+#define JUNCTION_DEFAULT_TICKS_PER_SECOND 60
+
+// Where junctionFindVehicle found a vehicle
+#define JUNCTION_NOT_FOUND 0
+#define JUNCTION_QUEUED 1     // Waiting in its lane queue
+#define JUNCTION_IN_FLIGHT 2  // Crossing the junction
+
+#include "signalPlan.h"
+#include "scenario.h"
+#include "waitHistogram.h"
+
+typedef struct Junction Junction;
+
+typedef struct {
+    int maxActive;           // Vehicles allowed inside the junction, 0 => no limit
+    int maxReleasePerTick;   // Vehicles released from the queues per step, 0 => no limit
+    int workerThreads;       // Threads used to move vehicles, 0 => one per core
+    int ticksPerSecond;      // Simulated steps per second
+    SignalPlan plan;
+    unsigned int priorityLanes; // Bit (road * JUNCTION_LANES_PER_ROAD + lane) per priority lane
+    int promoteThreshold;    // Waiting vehicles before a lane is served early, 0 => never
+    bool fixedPoint;         // Integer vehicle motion, bit-identical on every build
+    int laneWidth;           // World units; each road is JUNCTION_LANES_PER_ROAD lanes wide
+    ScenarioRouting routing; // Arrival lanes and turning ratios
+} JunctionConfig;
+
+// One vehicle crossing the junction
+typedef struct {
+    char plate[JUNCTION_PLATE_SIZE + 1];
+    unsigned long long id;   // Packed plate, see junctionPlateId
+    int road, lane;          // Where it came from
+    int destRoad, destLane;  // Where it is going
+    unsigned long long arrivalTick; // Step it joined its lane queue
+    unsigned long long releaseTick; // Step it left the queue on green, 0 while queued
+    float prevX, prevY;      // Position before the last step
+    float x, y;              // Position after the last step
+} JunctionVehicle;
+
+// Running totals since the junction was created
+typedef struct {
+    unsigned long long arrived;          // Joined a lane queue
+    unsigned long long dropped;          // Lane queue was full, or lost on release
+    unsigned long long unrouted;         // Drew a lane with no turns, never queued
+    unsigned long long released;         // Left a queue on green
+    unsigned long long departed;         // Reached the destination lane
+    unsigned long long totalDelayTicks;  // Queue wait summed over released vehicles
+    unsigned long long maxDelayTicks;
+} JunctionStats;
+
+// Queue wait distribution in simulated seconds, from the wait histograms
+typedef struct {
+    unsigned long long count;  // Released vehicles measured
+    double mean;
+    double p50, p95, p99;      // Within about 3%
+    double max;
+} JunctionWaitStats;
+
+// Result of looking a vehicle up by plate
+typedef struct {
+    int state;               // JUNCTION_NOT_FOUND, JUNCTION_QUEUED or JUNCTION_IN_FLIGHT
+    int queuePosition;       // Vehicles ahead of it in its lane queue, when queued
+    JunctionVehicle vehicle; // Lanes always; positions only when in flight
+} JunctionVehicleLookup;
+
+void junctionDefaultConfig(JunctionConfig* config);
+bool junctionParseLanes(const char* text, unsigned int* mask);
+
+// Replaces the layout settings of config (lane width, tick rate, signal
+// plan, priority lanes, promotion and routing) with a scenario file's; see
+// README.md for the format. The compiled form is cached in "<path>.bin".
+bool junctionLoadScenario(const char* path, JunctionConfig* config);
+Junction* junctionCreate(const JunctionConfig* config);
+void junctionDestroy(Junction* junction);
+
+bool junctionSubmitArrival(Junction* junction, const char* plate, int road);
+bool junctionSubmitVehicle(Junction* junction, const char* plate, int road, int lane, int destRoad, int destLane);
+
+// Batch form for one road. Lanes and destinations are drawn with
+// rand_r(seed), so a thread feeding a road with its own seed does not wait
+// on rand()'s process-wide lock, and the same plates from the same seed
+// always get the same lanes. junctionSubmitArrival, or a NULL seed, uses rand().
+int junctionSubmitArrivals(Junction* junction, int road, const char* const plates[], int count, unsigned int* seed);
+
+// Trips: a vehicle that only names the road it leaves by. The lanes come
+// from a next-hop table over the scenario's turns, costed by route length
+// and by how many vehicles wait in each entry lane. The table is updated
+// at the end of each step, for the roads whose queues changed, so routing
+// a trip is a single lookup. Both calls may come from any thread.
+bool junctionRouteTrip(const Junction* junction, int road, int destRoad, int* lane, int* destLane);
+bool junctionSubmitTrip(Junction* junction, const char* plate, int road, int destRoad);
+void junctionStep(Junction* junction);
+
+unsigned long long junctionTick(const Junction* junction);
+int junctionTicksPerSecond(const Junction* junction);
+double junctionSimSeconds(const Junction* junction);
+int junctionGreenRoad(const Junction* junction);
+int junctionLaneWidth(const Junction* junction);
+const char* junctionRoadName(const Junction* junction, int road);
+int junctionQueueLength(const Junction* junction, int road, int lane);
+int junctionVehicleCount(const Junction* junction);
+int junctionGetVehicles(const Junction* junction, JunctionVehicle* vehicles, int max);
+void junctionGetStats(const Junction* junction, JunctionStats* stats);
+
+// How long released vehicles waited in their lane queue. A road of -1
+// covers the whole junction and a lane of -1 the whole road; the histogram
+// form is in ticks and can be merged with others.
+void junctionGetWaitHistogram(const Junction* junction, int road, int lane, WaitHistogram* histogram);
+void junctionGetWaitStats(const Junction* junction, int road, int lane, JunctionWaitStats* stats);
+
+// Vehicle lookup in constant time. A plate is tracked from the step it
+// joins a lane queue until it departs; while two vehicles share a plate,
+// only the first one is tracked.
+unsigned long long junctionPlateId(const char* plate);
+int junctionFindVehicle(const Junction* junction, unsigned long long id, JunctionVehicleLookup* lookup);
+
+// Persistence. Restore must happen before the first step.
+bool junctionRestore(Junction* junction, const char* path);
+bool junctionStartCheckpoints(Junction* junction, const char* path, int everySeconds);
+bool junctionStartRecording(Junction* junction, const char* path);
+bool junctionStartReplay(Junction* junction, const char* path);
+bool junctionReplaying(const Junction* junction);
+
+// Publishes every step into the POSIX shared memory object `name` (e.g.
+// "/junction"): lights, lane queue lengths and up to maxVehicles in-flight
+// vehicles (0 => SHARED_STATE_DEFAULT_VEHICLES). Readers in other
+// processes map it read-only with sharedState.h; the step never waits for
+// them. The object is removed by junctionDestroy.
+bool junctionStartSharedState(Junction* junction, const char* name, int maxVehicles);
+
+#endif
@@ -0,0 +1,84 @@
+#include "laneScheduler.h"
+#include <stdio.h>
+#include <string.h>
+
+_Static_assert(LANE_SLOTS <= 32, "lane slots must fit in one bitmap word");
+
+void initLaneScheduler(LaneScheduler* scheduler, int promoteThreshold) {
+    memset(scheduler, 0, sizeof(*scheduler));
+    memset(scheduler->level, -1, sizeof(scheduler->level));
+    scheduler->promoteThreshold = promoteThreshold;
+}
+
+// Refiles a slot after its queue changed. Call after every enqueue and dequeue.
+void laneSchedulerUpdate(LaneScheduler* scheduler, int slot, int waiting, bool isPriority) {
+    int level = -1;
+    if (waiting > 0) {
+        if (isPriority) level = LANE_LEVEL_PRIORITY;
+        else if (scheduler->promoteThreshold > 0 && waiting > scheduler->promoteThreshold) level = LANE_LEVEL_PROMOTED;
+        else level = LANE_LEVEL_NORMAL;
+    }
+    if (scheduler->level[slot] == level) return;
+
+    unsigned int bit = 1u << slot;
+    if (scheduler->level[slot] >= 0) scheduler->ready[(int)scheduler->level[slot]] &= ~bit;
+    if (level >= 0) scheduler->ready[level] |= bit;
+    scheduler->level[slot] = (signed char)level;
+}
+
+// Refiles every lane, e.g. after a checkpoint refilled the queues
+void laneSchedulerRebuild(LaneScheduler* scheduler, Road* roads[MAX_ROADS]) {
+    for (int i = 0; i < MAX_ROADS; i++) {
+        for (int j = 0; j < MAX_LANE_SIZE; j++) {
+            Lane* lane = &roads[i]->lanes[j];
+            laneSchedulerUpdate(scheduler, i * MAX_LANE_SIZE + j, lane->queue.count, lane->isPriority);
+        }
+    }
+}
+
+// Next slot to serve among the `eligible` ones, -1 when none is waiting.
+// Higher levels always win; within a level lanes take turns.
+int laneSchedulerNext(LaneScheduler* scheduler, unsigned int eligible) {
+    for (int level = 0; level < LANE_LEVELS; level++) {
+        unsigned int candidates = scheduler->ready[level] & eligible;
+        if (candidates == 0) continue;
+
+        // First candidate at or after the cursor, wrapping around
+        unsigned int after = candidates & ~((1u << scheduler->cursor[level]) - 1);
+        int slot = __builtin_ctz(after ? after : candidates);
+        scheduler->cursor[level] = (slot + 1) % LANE_SLOTS;
+        return slot;
+    }
+    return -1;
+}
+
+unsigned int roadLaneMask(int roadIndex) {
+    return ((1u << MAX_LANE_SIZE) - 1) << (roadIndex * MAX_LANE_SIZE);
+}
+
+// Parses lanes written as road letter and lane number, e.g. "A2,C1"
+bool parseLaneList(const char* text, unsigned int* mask) {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    *mask = 0;
+
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char road;
+        int lane;
+        if (sscanf(item, " %c%d", &road, &lane) != 2 ||
+            road < 'A' || road >= 'A' + MAX_ROADS || lane < 1 || lane > MAX_LANE_SIZE) {
+            printf("Invalid lane: %s\n", item);
+            return false;
+        }
+        *mask |= 1u << ((road - 'A') * MAX_LANE_SIZE + lane - 1);
+    }
+    return true;
+}
+
+void markPriorityLanes(Road* roads[MAX_ROADS], unsigned int mask) {
+    for (int i = 0; i < MAX_ROADS; i++) {
+        for (int j = 0; j < MAX_LANE_SIZE; j++) {
+            roads[i]->lanes[j].isPriority = (mask >> (i * MAX_LANE_SIZE + j)) & 1u;
+        }
+    }
+}
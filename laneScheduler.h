@@ -0,0 +1,35 @@
+#ifndef LANESCHEDULER_H
+#define LANESCHEDULER_H
+#include <stdbool.h>
+#include "dataManagement.h"
+
+// Every lane of the junction has a slot: road * MAX_LANE_SIZE + lane
+#define LANE_SLOTS (MAX_ROADS * MAX_LANE_SIZE)
+
+// Service levels, served strictly in this order
+enum {
+    LANE_LEVEL_PRIORITY,  // Lane marked isPriority (emergency, bus)
+    LANE_LEVEL_PROMOTED,  // More than promoteThreshold vehicles waiting
+    LANE_LEVEL_NORMAL,    // Anything else with a vehicle waiting
+    LANE_LEVELS
+};
+
+// Multi-level ready set. Each level is a bitmap of lane slots with
+// vehicles waiting, so picking the next lane is a mask and a bit scan per
+// level instead of a walk over every lane.
+typedef struct {
+    unsigned int ready[LANE_LEVELS];
+    signed char level[LANE_SLOTS];  // Level a slot is filed under, -1 when empty
+    int cursor[LANE_LEVELS];        // Round robin position within each level
+    int promoteThreshold;           // 0 => never promote
+} LaneScheduler;
+
+void initLaneScheduler(LaneScheduler* scheduler, int promoteThreshold);
+void laneSchedulerUpdate(LaneScheduler* scheduler, int slot, int waiting, bool isPriority);
+void laneSchedulerRebuild(LaneScheduler* scheduler, Road* roads[MAX_ROADS]);
+int laneSchedulerNext(LaneScheduler* scheduler, unsigned int eligible);
+unsigned int roadLaneMask(int roadIndex);
+bool parseLaneList(const char* text, unsigned int* mask);
+void markPriorityLanes(Road* roads[MAX_ROADS], unsigned int mask);
+
+#endif
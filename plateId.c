@@ -0,0 +1,18 @@
+#include "plateId.h"
+
+// Packs up to PLATE_SIZE characters; anything after that is ignored
+PlateId packPlate(const char* plate) {
+    PlateId id = 0;
+    int i = 0;
+    for (; i < PLATE_SIZE && plate[i] != '\0'; i++) {
+        id = (id << 8) | (unsigned char)plate[i];
+    }
+    return id << (8 * (PLATE_SIZE - i));
+}
+
+void unpackPlate(PlateId id, char plate[PLATE_SIZE + 1]) {
+    for (int i = 0; i < PLATE_SIZE; i++) {
+        plate[i] = (char)(id >> (8 * (PLATE_SIZE - 1 - i)));
+    }
+    plate[PLATE_SIZE] = '\0';
+}
@@ -0,0 +1,18 @@
+#ifndef PLATEID_H
+#define PLATEID_H
+#include <stdint.h>
+
+#define PLATE_SIZE 8 // Characters in a plate, e.g. "AB1CD234"
+
+// A plate packed into one integer: one byte per character, first character
+// in the top byte, shorter plates padded with zero bytes. Comparing or
+// hashing an ID is one instruction instead of a string walk, and the empty
+// plate packs to PLATE_ID_NONE.
+typedef uint64_t PlateId;
+
+#define PLATE_ID_NONE 0
+
+PlateId packPlate(const char* plate);
+void unpackPlate(PlateId id, char plate[PLATE_SIZE + 1]);
+
+#endif
@@ -0,0 +1,209 @@
+#include "renderBatch.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void initGeometryBatch(GeometryBatch* batch) {
+    batch->vertices = NULL;
+    batch->vertexCount = 0;
+    batch->vertexCapacity = 0;
+    batch->indices = NULL;
+    batch->indexCount = 0;
+    batch->indexCapacity = 0;
+}
+
+void freeGeometryBatch(GeometryBatch* batch) {
+    free(batch->vertices);
+    free(batch->indices);
+    initGeometryBatch(batch);
+}
+
+void clearGeometryBatch(GeometryBatch* batch) {
+    batch->vertexCount = 0;
+    batch->indexCount = 0;
+}
+
+// Makes room for more vertices and indices; returns the first new vertex index or -1
+static int reserveBatch(GeometryBatch* batch, int vertices, int indices) {
+    if (batch->vertexCount + vertices > batch->vertexCapacity) {
+        int newCapacity = batch->vertexCapacity > 0 ? batch->vertexCapacity * 2 : 1024;
+        while (newCapacity < batch->vertexCount + vertices) newCapacity *= 2;
+        SDL_Vertex* grown = (SDL_Vertex*)realloc(batch->vertices, sizeof(SDL_Vertex) * newCapacity);
+        if (grown == NULL) {
+            printf("Error: could not grow geometry batch to %d vertices\n", newCapacity);
+            return -1;
+        }
+        batch->vertices = grown;
+        batch->vertexCapacity = newCapacity;
+    }
+    if (batch->indexCount + indices > batch->indexCapacity) {
+        int newCapacity = batch->indexCapacity > 0 ? batch->indexCapacity * 2 : 1536;
+        while (newCapacity < batch->indexCount + indices) newCapacity *= 2;
+        int* grown = (int*)realloc(batch->indices, sizeof(int) * newCapacity);
+        if (grown == NULL) {
+            printf("Error: could not grow geometry batch to %d indices\n", newCapacity);
+            return -1;
+        }
+        batch->indices = grown;
+        batch->indexCapacity = newCapacity;
+    }
+    return batch->vertexCount;
+}
+
+static void putVertex(GeometryBatch* batch, float x, float y, float u, float v, SDL_Color color) {
+    SDL_Vertex* vertex = &batch->vertices[batch->vertexCount++];
+    vertex->position.x = x;
+    vertex->position.y = y;
+    vertex->color = color;
+    vertex->tex_coord.x = u;
+    vertex->tex_coord.y = v;
+}
+
+// Quad with corners given clockwise from the top-left
+static void putQuad(GeometryBatch* batch,
+                    float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4,
+                    float u1, float v1, float u2, float v2, SDL_Color color) {
+    int base = reserveBatch(batch, 4, 6);
+    if (base < 0) return;
+    putVertex(batch, x1, y1, u1, v1, color);
+    putVertex(batch, x2, y2, u2, v1, color);
+    putVertex(batch, x3, y3, u2, v2, color);
+    putVertex(batch, x4, y4, u1, v2, color);
+    int* index = &batch->indices[batch->indexCount];
+    index[0] = base;     index[1] = base + 1; index[2] = base + 2;
+    index[3] = base;     index[4] = base + 2; index[5] = base + 3;
+    batch->indexCount += 6;
+}
+
+void batchFillRect(GeometryBatch* batch, float x, float y, float w, float h, SDL_Color color) {
+    putQuad(batch, x, y, x + w, y, x + w, y + h, x, y + h, 0, 0, 0, 0, color);
+}
+
+// One pixel wide outline covering the same pixels as SDL_RenderDrawRect
+void batchDrawRect(GeometryBatch* batch, float x, float y, float w, float h, SDL_Color color) {
+    batchFillRect(batch, x, y, w, 1, color);
+    batchFillRect(batch, x, y + h - 1, w, 1, color);
+    batchFillRect(batch, x, y + 1, 1, h - 2, color);
+    batchFillRect(batch, x + w - 1, y + 1, 1, h - 2, color);
+}
+
+// One pixel wide line, endpoints included like SDL_RenderDrawLine
+void batchDrawLine(GeometryBatch* batch, float x1, float y1, float x2, float y2, SDL_Color color) {
+    if (y1 == y2) {
+        float left = x1 < x2 ? x1 : x2;
+        batchFillRect(batch, left, y1, fabsf(x2 - x1) + 1, 1, color);
+        return;
+    }
+    if (x1 == x2) {
+        float top = y1 < y2 ? y1 : y2;
+        batchFillRect(batch, x1, top, 1, fabsf(y2 - y1) + 1, color);
+        return;
+    }
+    // Diagonal: a thin quad around the pixel centres
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float length = sqrtf(dx * dx + dy * dy);
+    float nx = -dy / length * 0.5f;
+    float ny = dx / length * 0.5f;
+    x1 += 0.5f; y1 += 0.5f; x2 += 0.5f; y2 += 0.5f;
+    putQuad(batch, x1 + nx, y1 + ny, x2 + nx, y2 + ny, x2 - nx, y2 - ny, x1 - nx, y1 - ny,
+            0, 0, 0, 0, color);
+}
+
+void batchTriangle(GeometryBatch* batch, float x1, float y1, float x2, float y2, float x3, float y3, SDL_Color color) {
+    int base = reserveBatch(batch, 3, 3);
+    if (base < 0) return;
+    putVertex(batch, x1, y1, 0, 0, color);
+    putVertex(batch, x2, y2, 0, 0, color);
+    putVertex(batch, x3, y3, 0, 0, color);
+    batch->indices[batch->indexCount++] = base;
+    batch->indices[batch->indexCount++] = base + 1;
+    batch->indices[batch->indexCount++] = base + 2;
+}
+
+// Submits everything collected so far as one draw call and empties the batch
+bool flushGeometryBatch(SDL_Renderer* renderer, GeometryBatch* batch, SDL_Texture* texture) {
+    bool ok = true;
+    if (batch->indexCount > 0 &&
+        SDL_RenderGeometry(renderer, texture, batch->vertices, batch->vertexCount,
+                           batch->indices, batch->indexCount) < 0) {
+        SDL_Log("Failed to render geometry batch: %s", SDL_GetError());
+        ok = false;
+    }
+    clearGeometryBatch(batch);
+    return ok;
+}
+
+bool initGlyphAtlas(GlyphAtlas* atlas, SDL_Renderer* renderer, TTF_Font* font) {
+    const int glyphCount = GLYPH_LAST - GLYPH_FIRST + 1;
+    SDL_Surface* glyphSurfaces[GLYPH_LAST - GLYPH_FIRST + 1] = {0};
+    SDL_Color white = {255, 255, 255, 255}; // Tinted per vertex when drawn
+    int cellWidth = 0;
+    int cellHeight = 0;
+
+    atlas->texture = NULL;
+    for (int i = 0; i < glyphCount; i++) {
+        char text[2] = {(char)(GLYPH_FIRST + i), '\0'};
+        glyphSurfaces[i] = TTF_RenderText_Blended(font, text, white);
+        if (!glyphSurfaces[i]) continue;
+        if (glyphSurfaces[i]->w > cellWidth) cellWidth = glyphSurfaces[i]->w;
+        if (glyphSurfaces[i]->h > cellHeight) cellHeight = glyphSurfaces[i]->h;
+    }
+
+    int rows = (glyphCount + GLYPH_ATLAS_COLUMNS - 1) / GLYPH_ATLAS_COLUMNS;
+    atlas->width = cellWidth * GLYPH_ATLAS_COLUMNS;
+    atlas->height = cellHeight * rows;
+    SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, atlas->width, atlas->height, 32,
+                                                        SDL_PIXELFORMAT_RGBA32);
+    if (!sheet) {
+        SDL_Log("Failed to create glyph atlas surface: %s", SDL_GetError());
+    }
+
+    for (int i = 0; i < glyphCount; i++) {
+        SDL_Rect* cell = &atlas->glyphs[i];
+        cell->x = (i % GLYPH_ATLAS_COLUMNS) * cellWidth;
+        cell->y = (i / GLYPH_ATLAS_COLUMNS) * cellHeight;
+        cell->w = 0;
+        cell->h = 0;
+        if (!glyphSurfaces[i]) continue;
+        cell->w = glyphSurfaces[i]->w;
+        cell->h = glyphSurfaces[i]->h;
+        if (sheet) {
+            // Copy the glyph's alpha as-is instead of blending it onto the sheet
+            SDL_SetSurfaceBlendMode(glyphSurfaces[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(glyphSurfaces[i], NULL, sheet, cell);
+        }
+        SDL_FreeSurface(glyphSurfaces[i]);
+    }
+    if (!sheet) return false;
+
+    atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+    SDL_FreeSurface(sheet);
+    if (!atlas->texture) {
+        SDL_Log("Failed to create glyph atlas texture: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+void freeGlyphAtlas(GlyphAtlas* atlas) {
+    if (atlas->texture) SDL_DestroyTexture(atlas->texture);
+    atlas->texture = NULL;
+}
+
+// Adds one textured quad per character; flush with the atlas texture
+void batchText(GeometryBatch* batch, const GlyphAtlas* atlas, const char* text, float x, float y, SDL_Color color) {
+    for (const char* c = text; *c; c++) {
+        if (*c < GLYPH_FIRST || *c > GLYPH_LAST) continue;
+        const SDL_Rect* glyph = &atlas->glyphs[*c - GLYPH_FIRST];
+        if (glyph->w == 0) continue;
+        float u1 = (float)glyph->x / atlas->width;
+        float v1 = (float)glyph->y / atlas->height;
+        float u2 = (float)(glyph->x + glyph->w) / atlas->width;
+        float v2 = (float)(glyph->y + glyph->h) / atlas->height;
+        putQuad(batch, x, y, x + glyph->w, y, x + glyph->w, y + glyph->h, x, y + glyph->h,
+                u1, v1, u2, v2, color);
+        x += glyph->w;
+    }
+}
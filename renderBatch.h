@@ -0,0 +1,52 @@
+#ifndef RENDERBATCH_H
+#define RENDERBATCH_H
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#define GLYPH_FIRST 32
+#define GLYPH_LAST 126
+#define GLYPH_ATLAS_COLUMNS 16
+
+// Triangles collected over a frame and submitted with one SDL_RenderGeometry
+// call. Every vertex carries its own colour, so mixed colours share a batch
+// and draw order inside the batch is the order shapes were added.
+typedef struct {
+    SDL_Vertex* vertices;
+    int vertexCount;
+    int vertexCapacity;
+    int* indices;
+    int indexCount;
+    int indexCapacity;
+} GeometryBatch;
+
+// All printable ASCII glyphs rendered once into one texture, so text can be
+// drawn as textured quads in a single batch instead of a texture per string
+typedef struct {
+    SDL_Texture* texture;
+    SDL_Rect glyphs[GLYPH_LAST - GLYPH_FIRST + 1];
+    int width;
+    int height;
+} GlyphAtlas;
+
+// Everything drawn in one frame: coloured shapes first, then text on top
+typedef struct {
+    GeometryBatch shapes;
+    GeometryBatch text;
+    GlyphAtlas atlas;
+} FrameBatch;
+
+void initGeometryBatch(GeometryBatch* batch);
+void freeGeometryBatch(GeometryBatch* batch);
+void clearGeometryBatch(GeometryBatch* batch);
+void batchFillRect(GeometryBatch* batch, float x, float y, float w, float h, SDL_Color color);
+void batchDrawRect(GeometryBatch* batch, float x, float y, float w, float h, SDL_Color color);
+void batchDrawLine(GeometryBatch* batch, float x1, float y1, float x2, float y2, SDL_Color color);
+void batchTriangle(GeometryBatch* batch, float x1, float y1, float x2, float y2, float x3, float y3, SDL_Color color);
+bool flushGeometryBatch(SDL_Renderer* renderer, GeometryBatch* batch, SDL_Texture* texture);
+
+bool initGlyphAtlas(GlyphAtlas* atlas, SDL_Renderer* renderer, TTF_Font* font);
+void freeGlyphAtlas(GlyphAtlas* atlas);
+void batchText(GeometryBatch* batch, const GlyphAtlas* atlas, const char* text, float x, float y, SDL_Color color);
+
+#endif
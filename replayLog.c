@@ -0,0 +1,127 @@
+#include "replayLog.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_BUFFER_SIZE (1 << 20)
+
+bool openReplayRecorder(ReplayLog* log, const char* path) {
+    memset(log, 0, sizeof(*log));
+    log->file = fopen(path, "wb");
+    if (!log->file) {
+        perror("Error opening replay log for recording");
+        return false;
+    }
+    // Large stdio buffer so recording costs a memcpy per event on the tick
+    setvbuf(log->file, NULL, _IOFBF, REPLAY_BUFFER_SIZE);
+    log->writing = true;
+
+    ReplayHeader header = {REPLAY_MAGIC, REPLAY_VERSION, sizeof(ReplayRecord)};
+    if (fwrite(&header, sizeof(header), 1, log->file) != 1) {
+        perror("Error writing replay log header");
+        fclose(log->file);
+        log->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Reads the record after the current one into log->next
+static void readAhead(ReplayLog* log) {
+    log->hasNext = fread(&log->next, sizeof(ReplayRecord), 1, log->file) == 1;
+}
+
+bool openReplayPlayer(ReplayLog* log, const char* path) {
+    memset(log, 0, sizeof(*log));
+    log->file = fopen(path, "rb");
+    if (!log->file) {
+        perror("Error opening replay log");
+        return false;
+    }
+    setvbuf(log->file, NULL, _IOFBF, REPLAY_BUFFER_SIZE);
+
+    ReplayHeader header;
+    if (fread(&header, sizeof(header), 1, log->file) != 1 ||
+        header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION ||
+        header.recordSize != sizeof(ReplayRecord)) {
+        printf("Error: %s is not a replay log written by this build\n", path);
+        fclose(log->file);
+        log->file = NULL;
+        return false;
+    }
+    readAhead(log);
+    return true;
+}
+
+void closeReplayLog(ReplayLog* log) {
+    if (!log->file) return;
+    if (log->writing) {
+        printf("Replay log closed after %llu records\n", log->recordCount);
+    }
+    fclose(log->file);
+    log->file = NULL;
+}
+
+static void writeRecord(ReplayLog* log, const ReplayRecord* record) {
+    if (!log->file || !log->writing) return;
+    if (fwrite(record, sizeof(*record), 1, log->file) != 1) {
+        perror("Error writing replay log");
+        return;
+    }
+    log->recordCount++;
+}
+
+void recordArrival(ReplayLog* log, Road* roads[MAX_ROADS], unsigned long long tick, const Vehicle* vehicle) {
+    ReplayRecord record;
+    int roadIndex, laneIndex, destRoadIndex, destLaneIndex;
+
+    memset(&record, 0, sizeof(record));
+    record.tick = tick;
+    record.type = REPLAY_ARRIVAL;
+    memcpy(record.plate, vehicle->VechicleName, sizeof(record.plate));
+    laneToIndex(roads, vehicle->currentLane, &roadIndex, &laneIndex);
+    laneToIndex(roads, vehicle->destinationLane, &destRoadIndex, &destLaneIndex);
+    record.roadIndex = (signed char)roadIndex;
+    record.laneIndex = (signed char)laneIndex;
+    record.destRoadIndex = (signed char)destRoadIndex;
+    record.destLaneIndex = (signed char)destLaneIndex;
+    record.light = -1;
+    writeRecord(log, &record);
+}
+
+void recordLightChange(ReplayLog* log, unsigned long long tick, int light) {
+    ReplayRecord record;
+
+    memset(&record, 0, sizeof(record));
+    record.tick = tick;
+    record.type = REPLAY_LIGHT_CHANGE;
+    record.roadIndex = record.laneIndex = record.destRoadIndex = record.destLaneIndex = -1;
+    record.light = (signed char)light;
+    writeRecord(log, &record);
+}
+
+// Returns the next record stamped with `tick` or earlier, false once the
+// log has nothing more for this tick. Call repeatedly at the start of a tick.
+bool nextReplayRecord(ReplayLog* log, unsigned long long tick, ReplayRecord* record) {
+    if (!log->hasNext || log->next.tick > tick) return false;
+    *record = log->next;
+    log->recordCount++;
+    readAhead(log);
+    return true;
+}
+
+bool replayFinished(const ReplayLog* log) {
+    return !log->hasNext;
+}
+
+bool replayRecordToVehicle(Road* roads[MAX_ROADS], const ReplayRecord* record, Vehicle* vehicle) {
+    memset(vehicle, 0, sizeof(*vehicle));
+    setVehiclePlate(vehicle, record->plate);
+    vehicle->currentLane = indexToLane(roads, record->roadIndex, record->laneIndex);
+    vehicle->destinationLane = indexToLane(roads, record->destRoadIndex, record->destLaneIndex);
+    if (vehicle->currentLane == NULL || vehicle->destinationLane == NULL) {
+        printf("Error: replay record for %.8s has an invalid lane\n", record->plate);
+        return false;
+    }
+    vehicle->road = vehicle->currentLane->road;
+    return true;
+}
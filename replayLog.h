@@ -0,0 +1,50 @@
+#ifndef REPLAYLOG_H
+#define REPLAYLOG_H
+#include <stdbool.h>
+#include <stdio.h>
+#include "dataManagement.h"
+
+#define REPLAY_MAGIC 0x50524E4A // "JNRP"
+#define REPLAY_VERSION 1
+
+#define REPLAY_ARRIVAL 1      // A vehicle entered the simulation
+#define REPLAY_LIGHT_CHANGE 2 // The light thread asked for a new phase
+
+// One input event, stamped with the simulation tick it took effect on.
+// Lanes are stored as indices so a log can be replayed in a fresh process.
+typedef struct {
+    unsigned long long tick;
+    unsigned char type;
+    char plate[PLATE_SIZE];
+    signed char roadIndex;
+    signed char laneIndex;
+    signed char destRoadIndex;
+    signed char destLaneIndex;
+    signed char light;
+} ReplayRecord;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int recordSize;
+} ReplayHeader;
+
+// An input log opened either for recording or for playback
+typedef struct {
+    FILE* file;
+    bool writing;
+    bool hasNext;        // Playback: `next` holds a record not yet returned
+    ReplayRecord next;
+    unsigned long long recordCount;
+} ReplayLog;
+
+bool openReplayRecorder(ReplayLog* log, const char* path);
+bool openReplayPlayer(ReplayLog* log, const char* path);
+void closeReplayLog(ReplayLog* log);
+void recordArrival(ReplayLog* log, Road* roads[MAX_ROADS], unsigned long long tick, const Vehicle* vehicle);
+void recordLightChange(ReplayLog* log, unsigned long long tick, int light);
+bool nextReplayRecord(ReplayLog* log, unsigned long long tick, ReplayRecord* record);
+bool replayFinished(const ReplayLog* log);
+bool replayRecordToVehicle(Road* roads[MAX_ROADS], const ReplayRecord* record, Vehicle* vehicle);
+
+#endif
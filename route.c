@@ -0,0 +1,249 @@
+#include "route.h"
+#include <math.h>
+#include <stdint.h>
+
+int routeIndex(int road, int lane, int destRoad, int destLane) {
+    return (road * MAX_LANE_SIZE + lane) * ROUTE_LANES + destRoad * MAX_LANE_SIZE + destLane;
+}
+
+// Lane position in world coordinates: start is the edge of the world,
+// end is where the lane meets the junction
+void laneCoordinates(int road, int lane, int laneWidth, float* startX, float* startY, float* endX, float* endY) {
+    // World center
+    float centerX = WORLD_SIZE / 2;
+    float centerY = WORLD_SIZE / 2;
+    float laneOffset = laneWidth * lane + laneWidth / 2;
+    int roadWidth = laneWidth * MAX_LANE_SIZE;
+
+    // Calculate based on road orientation
+    switch (road) {
+        case 0: // Road A (bottom)
+            *startX = centerX - roadWidth / 2 + laneOffset;
+            *startY = WORLD_SIZE;
+            *endX = centerX - roadWidth / 2 + laneOffset;
+            *endY = centerY + roadWidth / 2;
+            break;
+        case 1: // Road B (top)
+            *startX = centerX + roadWidth / 2 - laneOffset;
+            *startY = 0;
+            *endX = centerX + roadWidth / 2 - laneOffset;
+            *endY = centerY - roadWidth / 2;
+            break;
+        case 2: // Road C (right)
+            *startX = WORLD_SIZE;
+            *startY = centerY - roadWidth / 2 + laneOffset;
+            *endX = centerX + roadWidth / 2;
+            *endY = centerY - roadWidth / 2 + laneOffset;
+            break;
+        case 3: // Road D (left)
+            *startX = 0;
+            *startY = centerY + roadWidth / 2 - laneOffset;
+            *endX = centerX - roadWidth / 2;
+            *endY = centerY + roadWidth / 2 - laneOffset;
+            break;
+        default:
+            *startX = *startY = *endX = *endY = 0;
+            break;
+    }
+}
+
+// Dense polyline of a route: the entry and exit lanes are straight, the
+// turn is a cubic Bézier leaving the source lane and joining the
+// destination lane along their own directions, so there are no corners
+#define ROUTE_POINTS (ROUTE_CURVE_STEPS + 3)
+
+static void routePolyline(int road, int lane, int destRoad, int destLane, int laneWidth,
+                          float px[ROUTE_POINTS], float py[ROUTE_POINTS]) {
+    float sx, sy, entryX, entryY, outX, outY, exitX, exitY;
+    laneCoordinates(road, lane, laneWidth, &sx, &sy, &entryX, &entryY);
+    laneCoordinates(destRoad, destLane, laneWidth, &outX, &outY, &exitX, &exitY);
+
+    // Unit directions of travel into and out of the junction
+    float inX = entryX - sx, inY = entryY - sy;
+    float inLength = sqrtf(inX * inX + inY * inY);
+    float leaveX = outX - exitX, leaveY = outY - exitY;
+    float leaveLength = sqrtf(leaveX * leaveX + leaveY * leaveY);
+    inX /= inLength; inY /= inLength;
+    leaveX /= leaveLength; leaveY /= leaveLength;
+
+    // Control points half the chord away along each direction
+    float chord = sqrtf((exitX - entryX) * (exitX - entryX) + (exitY - entryY) * (exitY - entryY));
+    float handle = chord > 0 ? chord / 2 : laneWidth * MAX_LANE_SIZE / 2;
+    float c1x = entryX + inX * handle, c1y = entryY + inY * handle;
+    float c2x = exitX - leaveX * handle, c2y = exitY - leaveY * handle;
+
+    px[0] = sx;
+    py[0] = sy;
+    for (int i = 0; i <= ROUTE_CURVE_STEPS; i++) {
+        float t = (float)i / ROUTE_CURVE_STEPS, u = 1 - t;
+        float b0 = u * u * u, b1 = 3 * u * u * t, b2 = 3 * u * t * t, b3 = t * t * t;
+        px[i + 1] = b0 * entryX + b1 * c1x + b2 * c2x + b3 * exitX;
+        py[i + 1] = b0 * entryY + b1 * c1y + b2 * c2y + b3 * exitY;
+    }
+    px[ROUTE_POINTS - 1] = outX;
+    py[ROUTE_POINTS - 1] = outY;
+}
+
+// Measures the polyline and resamples it at equal arc-length steps
+static void buildRoute(Route* route, int road, int lane, int destRoad, int destLane, int laneWidth) {
+    float px[ROUTE_POINTS], py[ROUTE_POINTS], along[ROUTE_POINTS];
+    routePolyline(road, lane, destRoad, destLane, laneWidth, px, py);
+
+    along[0] = 0;
+    for (int i = 1; i < ROUTE_POINTS; i++) {
+        float dx = px[i] - px[i - 1], dy = py[i] - py[i - 1];
+        along[i] = along[i - 1] + sqrtf(dx * dx + dy * dy);
+    }
+    route->length = along[ROUTE_POINTS - 1];
+    route->perUnit = route->length > 0 ? (ROUTE_SAMPLES - 1) / route->length : 0;
+
+    int segment = 1;
+    for (int i = 0; i < ROUTE_SAMPLES; i++) {
+        float target = route->length * i / (ROUTE_SAMPLES - 1);
+        while (segment < ROUTE_POINTS - 1 && along[segment] < target) segment++;
+        float span = along[segment] - along[segment - 1];
+        float f = span > 0 ? (target - along[segment - 1]) / span : 0;
+        route->x[i] = px[segment - 1] + (px[segment] - px[segment - 1]) * f;
+        route->y[i] = py[segment - 1] + (py[segment] - py[segment - 1]) * f;
+    }
+}
+
+// Position `distance` world units along the route, clamped to its ends
+void routePosition(const Route* route, float distance, float* x, float* y) {
+    float sample = distance * route->perUnit;
+    if (sample <= 0) {
+        *x = route->x[0];
+        *y = route->y[0];
+        return;
+    }
+    int i = (int)sample;
+    if (i >= ROUTE_SAMPLES - 1) {
+        *x = route->x[ROUTE_SAMPLES - 1];
+        *y = route->y[ROUTE_SAMPLES - 1];
+        return;
+    }
+    float f = sample - i;
+    *x = route->x[i] + (route->x[i + 1] - route->x[i]) * f;
+    *y = route->y[i] + (route->y[i + 1] - route->y[i]) * f;
+}
+
+// Integer square root, rounded down
+static int64_t integerSqrt(uint64_t value) {
+    uint64_t root = 0, bit = 1ULL << 62;
+    while (bit > value) bit >>= 2;
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (int64_t)root;
+}
+
+// a / b rounded to nearest, b > 0
+static int64_t divideRounded(int64_t a, int64_t b) {
+    return a >= 0 ? (a + b / 2) / b : -((-a + b / 2) / b);
+}
+
+// Same shape as routePolyline, in fixed-point units with integer maths only.
+// Lane coordinates are whole world units, so they convert exactly.
+static void fixedRoutePolyline(int road, int lane, int destRoad, int destLane, int laneWidth,
+                               int64_t px[ROUTE_POINTS], int64_t py[ROUTE_POINTS]) {
+    float fsx, fsy, fentryX, fentryY, foutX, foutY, fexitX, fexitY;
+    laneCoordinates(road, lane, laneWidth, &fsx, &fsy, &fentryX, &fentryY);
+    laneCoordinates(destRoad, destLane, laneWidth, &foutX, &foutY, &fexitX, &fexitY);
+    int64_t sx = (int64_t)fsx * ROUTE_FIXED_ONE, sy = (int64_t)fsy * ROUTE_FIXED_ONE;
+    int64_t entryX = (int64_t)fentryX * ROUTE_FIXED_ONE, entryY = (int64_t)fentryY * ROUTE_FIXED_ONE;
+    int64_t outX = (int64_t)foutX * ROUTE_FIXED_ONE, outY = (int64_t)foutY * ROUTE_FIXED_ONE;
+    int64_t exitX = (int64_t)fexitX * ROUTE_FIXED_ONE, exitY = (int64_t)fexitY * ROUTE_FIXED_ONE;
+
+    int64_t inX = entryX - sx, inY = entryY - sy;
+    int64_t inLength = integerSqrt(inX * inX + inY * inY);
+    int64_t leaveX = outX - exitX, leaveY = outY - exitY;
+    int64_t leaveLength = integerSqrt(leaveX * leaveX + leaveY * leaveY);
+
+    int64_t chord = integerSqrt((exitX - entryX) * (exitX - entryX) + (exitY - entryY) * (exitY - entryY));
+    int64_t handle = chord > 0 ? chord / 2 : (int64_t)(laneWidth * MAX_LANE_SIZE / 2) * ROUTE_FIXED_ONE;
+    int64_t c1x = entryX + divideRounded(inX * handle, inLength);
+    int64_t c1y = entryY + divideRounded(inY * handle, inLength);
+    int64_t c2x = exitX - divideRounded(leaveX * handle, leaveLength);
+    int64_t c2y = exitY - divideRounded(leaveY * handle, leaveLength);
+
+    // Bernstein weights scaled by n^3, so the curve points are exact sums
+    const int64_t n = ROUTE_CURVE_STEPS;
+    px[0] = sx;
+    py[0] = sy;
+    for (int64_t t = 0; t <= n; t++) {
+        int64_t u = n - t;
+        int64_t b0 = u * u * u, b1 = 3 * u * u * t, b2 = 3 * u * t * t, b3 = t * t * t;
+        px[t + 1] = divideRounded(b0 * entryX + b1 * c1x + b2 * c2x + b3 * exitX, n * n * n);
+        py[t + 1] = divideRounded(b0 * entryY + b1 * c1y + b2 * c2y + b3 * exitY, n * n * n);
+    }
+    px[ROUTE_POINTS - 1] = outX;
+    py[ROUTE_POINTS - 1] = outY;
+}
+
+// Resamples the polyline every 2^ROUTE_FIXED_SPACING_SHIFT units. The
+// sample after the end is carried on along the exit lane, so the last
+// interval is as long as the others and lookups never special-case it.
+static void buildFixedRoute(FixedRoute* route, int road, int lane, int destRoad, int destLane, int laneWidth) {
+    int64_t px[ROUTE_POINTS], py[ROUTE_POINTS], along[ROUTE_POINTS];
+    fixedRoutePolyline(road, lane, destRoad, destLane, laneWidth, px, py);
+
+    along[0] = 0;
+    for (int i = 1; i < ROUTE_POINTS; i++) {
+        int64_t dx = px[i] - px[i - 1], dy = py[i] - py[i - 1];
+        along[i] = along[i - 1] + integerSqrt((uint64_t)(dx * dx + dy * dy));
+    }
+    int64_t length = along[ROUTE_POINTS - 1];
+    int64_t maxLength = (int64_t)(ROUTE_FIXED_SAMPLES - 2) << ROUTE_FIXED_SPACING_SHIFT;
+    if (length > maxLength) length = maxLength; // Longer than any real route; ends it early
+    route->length = (int32_t)length;
+
+    int used = (int)(length >> ROUTE_FIXED_SPACING_SHIFT) + 2;
+    int segment = 1;
+    for (int i = 0; i < ROUTE_FIXED_SAMPLES; i++) {
+        if (i >= used) {
+            route->x[i] = route->x[used - 1];
+            route->y[i] = route->y[used - 1];
+            continue;
+        }
+        int64_t target = (int64_t)i << ROUTE_FIXED_SPACING_SHIFT;
+        while (segment < ROUTE_POINTS - 1 && along[segment] < target) segment++;
+        int64_t span = along[segment] - along[segment - 1];
+        int64_t offset = target - along[segment - 1];
+        route->x[i] = (int16_t)(px[segment - 1] + (span > 0 ? divideRounded((px[segment] - px[segment - 1]) * offset, span) : 0));
+        route->y[i] = (int16_t)(py[segment - 1] + (span > 0 ? divideRounded((py[segment] - py[segment - 1]) * offset, span) : 0));
+    }
+}
+
+// Position in fixed-point units `distance` fixed-point units along the
+// route, clamped to its ends. Relies on >> of a negative value being an
+// arithmetic shift, as it is on every compiler this builds with.
+void fixedRoutePosition(const FixedRoute* route, int32_t distance, int32_t* x, int32_t* y) {
+    if (distance < 0) distance = 0;
+    if (distance > route->length) distance = route->length;
+    int i = distance >> ROUTE_FIXED_SPACING_SHIFT;
+    int32_t f = distance & ((1 << ROUTE_FIXED_SPACING_SHIFT) - 1);
+    *x = route->x[i] + (((route->x[i + 1] - route->x[i]) * f) >> ROUTE_FIXED_SPACING_SHIFT);
+    *y = route->y[i] + (((route->y[i + 1] - route->y[i]) * f) >> ROUTE_FIXED_SPACING_SHIFT);
+}
+
+// Every lane to every lane, including pairs no vehicle is ever given, so a
+// route is always a plain array lookup
+void buildRouteTable(RouteTable* table, int laneWidth) {
+    for (int road = 0; road < MAX_ROADS; road++) {
+        for (int lane = 0; lane < MAX_LANE_SIZE; lane++) {
+            for (int destRoad = 0; destRoad < MAX_ROADS; destRoad++) {
+                for (int destLane = 0; destLane < MAX_LANE_SIZE; destLane++) {
+                    int index = routeIndex(road, lane, destRoad, destLane);
+                    buildRoute(&table->routes[index], road, lane, destRoad, destLane, laneWidth);
+                    buildFixedRoute(&table->fixed[index], road, lane, destRoad, destLane, laneWidth);
+                }
+            }
+        }
+    }
+}
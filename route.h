@@ -0,0 +1,54 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+#include <stdint.h>
+#include "junction.h"
+#include "dataManagement.h"
+
+// Junction geometry in world units. Lane width comes from the scenario;
+// a road is MAX_LANE_SIZE lanes wide.
+#define WORLD_SIZE JUNCTION_WORLD_SIZE
+
+#define ROUTE_LANES (MAX_ROADS * MAX_LANE_SIZE)
+#define ROUTE_COUNT (ROUTE_LANES * ROUTE_LANES) // One route per source and destination lane
+#define ROUTE_SAMPLES 128                       // Points stored per route
+#define ROUTE_CURVE_STEPS 64                    // Segments used to measure a turn
+
+// Path from one lane to another: down the source lane to the junction, a
+// cubic Bézier through it, then out along the destination lane. The points
+// are spaced equally by arc length, so the position at any distance along
+// the route is one lookup and one interpolation.
+typedef struct {
+    float length;     // World units from start to end
+    float perUnit;    // Samples per world unit, (ROUTE_SAMPLES - 1) / length
+    float x[ROUTE_SAMPLES];
+    float y[ROUTE_SAMPLES];
+} Route;
+
+// Deterministic form of a route for the fixed-point mode. Built with
+// integer arithmetic only and read with shifts and masks, so every compiler
+// and optimisation level produces the same positions bit for bit. Points
+// are 1/32 world unit int16s, half the size of floats, and are spaced
+// ROUTE_FIXED_SPACING apart so finding the sample is a shift.
+#define ROUTE_FIXED_SHIFT 5                                  // Fixed-point units per world unit, as a power of two
+#define ROUTE_FIXED_ONE (1 << ROUTE_FIXED_SHIFT)
+#define ROUTE_FIXED_SPACING_SHIFT (ROUTE_FIXED_SHIFT + 3)   // Points every 8 world units
+#define ROUTE_FIXED_SAMPLES 160                              // Enough for any route up to 1272 units
+
+typedef struct {
+    int32_t length;   // Fixed-point units
+    int16_t x[ROUTE_FIXED_SAMPLES];
+    int16_t y[ROUTE_FIXED_SAMPLES];
+} FixedRoute;
+
+typedef struct {
+    Route routes[ROUTE_COUNT];
+    FixedRoute fixed[ROUTE_COUNT];
+} RouteTable;
+
+int routeIndex(int road, int lane, int destRoad, int destLane);
+void laneCoordinates(int road, int lane, int laneWidth, float* startX, float* startY, float* endX, float* endY);
+void buildRouteTable(RouteTable* table, int laneWidth);
+void routePosition(const Route* route, float distance, float* x, float* y);
+void fixedRoutePosition(const FixedRoute* route, int32_t distance, int32_t* x, int32_t* y);
+
+#endif
@@ -0,0 +1,73 @@
+#include "routing.h"
+#include <string.h>
+
+// Cheapest candidate for one origin and destination at the current queue lengths
+static void recomputeEntry(RoutingTable* table, int road, int destRoad) {
+    const RouteCandidates* candidates = &table->candidates[road][destRoad];
+    unsigned int best = ROUTING_NO_ROUTE;
+    float bestCost = 0;
+    for (int k = 0; k < candidates->count; k++) {
+        float cost = candidates->length[k] + ROUTING_QUEUED_COST * table->queued[candidates->from[k]];
+        if (best == ROUTING_NO_ROUTE || cost < bestCost) {
+            best = (unsigned int)candidates->from[k] << 8 | candidates->to[k];
+            bestCost = cost;
+        }
+    }
+    table->cost[road][destRoad] = bestCost;
+    atomic_store_explicit(&table->nextHop[road][destRoad], best, memory_order_release);
+}
+
+static void recomputeRow(RoutingTable* table, int road) {
+    for (int destRoad = 0; destRoad < MAX_ROADS; destRoad++) recomputeEntry(table, road, destRoad);
+}
+
+// Collects the candidates once from the scenario's turns; only the costs
+// change afterwards
+void buildRoutingTable(RoutingTable* table, const ScenarioRouting* routing, const RouteTable* routes) {
+    memset(table, 0, sizeof(*table));
+    for (int road = 0; road < MAX_ROADS; road++) {
+        const WeightedChoice* lanes = &routing->arrivalLane[road];
+        for (int i = 0; i < lanes->count; i++) {
+            int from = road * MAX_LANE_SIZE + lanes->option[i];
+            const WeightedChoice* turns = &routing->turn[from];
+            for (int k = 0; k < turns->count; k++) {
+                int to = turns->option[k];
+                RouteCandidates* candidates = &table->candidates[road][to / MAX_LANE_SIZE];
+                int n = candidates->count++;
+                candidates->from[n] = (unsigned char)from;
+                candidates->to[n] = (unsigned char)to;
+                candidates->length[n] = routes->routes[routeIndex(road, from % MAX_LANE_SIZE, to / MAX_LANE_SIZE,
+                                                                  to % MAX_LANE_SIZE)].length;
+            }
+        }
+    }
+    for (int road = 0; road < MAX_ROADS; road++) recomputeRow(table, road);
+}
+
+// Called on the simulation thread after each step. A queue length only
+// enters the costs of routes starting on its own road, so a change
+// recomputes that road's row and no other.
+void updateRoutingTable(RoutingTable* table, Road* roads[MAX_ROADS]) {
+    for (int road = 0; road < MAX_ROADS; road++) {
+        bool changed = false;
+        for (int lane = 0; lane < MAX_LANE_SIZE; lane++) {
+            int count = roads[road]->lanes[lane].queue.count;
+            int* queued = &table->queued[road * MAX_LANE_SIZE + lane];
+            if (*queued != count) {
+                *queued = count;
+                changed = true;
+            }
+        }
+        if (changed) recomputeRow(table, road);
+    }
+}
+
+// Entry and exit lane slots of the cheapest way from `road` out by
+// `destRoad`; false when the scenario has no turn between them
+bool lookupRoute(const RoutingTable* table, int road, int destRoad, int* laneSlot, int* destLaneSlot) {
+    unsigned int hop = atomic_load_explicit(&table->nextHop[road][destRoad], memory_order_acquire);
+    if (hop == ROUTING_NO_ROUTE) return false;
+    *laneSlot = (int)(hop >> 8);
+    *destLaneSlot = (int)(hop & 0xFF);
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef ROUTING_H
+#define ROUTING_H
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "route.h"
+#include "scenario.h"
+
+#define ROUTING_NO_ROUTE 0xFFFFu
+#define ROUTING_QUEUED_COST 60.0f                        // World units of travel one waiting vehicle costs
+#define ROUTING_MAX_CANDIDATES (MAX_LANE_SIZE * MAX_LANE_SIZE) // Entry lanes times exit lanes
+
+// Turns that take a vehicle from one road out by another: every entry lane
+// of the origin road that takes vehicles, paired with each of its turns
+// onto the destination road
+typedef struct {
+    int count;
+    unsigned char from[ROUTING_MAX_CANDIDATES];  // Lane slot it queues in
+    unsigned char to[ROUTING_MAX_CANDIDATES];    // Lane slot it leaves by
+    float length[ROUTING_MAX_CANDIDATES];        // Route length, the fixed part of the cost
+} RouteCandidates;
+
+// Next-hop table from origin road to destination road. A turn costs its
+// route length plus ROUTING_QUEUED_COST for every vehicle queued in its
+// entry lane. The table is rebuilt only for roads whose queues changed
+// since it was last computed; lookups are one atomic load, so any thread
+// can route while the simulation thread updates it.
+typedef struct {
+    RouteCandidates candidates[MAX_ROADS][MAX_ROADS];
+    float cost[MAX_ROADS][MAX_ROADS];
+    atomic_uint nextHop[MAX_ROADS][MAX_ROADS];   // from << 8 | to, or ROUTING_NO_ROUTE
+    int queued[ROUTE_LANES];                     // Queue lengths the table was built with
+} RoutingTable;
+
+void buildRoutingTable(RoutingTable* table, const ScenarioRouting* routing, const RouteTable* routes);
+void updateRoutingTable(RoutingTable* table, Road* roads[MAX_ROADS]);
+bool lookupRoute(const RoutingTable* table, int road, int destRoad, int* laneSlot, int* destLaneSlot);
+
+#endif
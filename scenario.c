@@ -0,0 +1,245 @@
+#include "scenario.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "junction.h"
+#include "dataManagement.h"
+#include "laneScheduler.h"
+
+#define SLOT(road, lane) ((road) * SCENARIO_LANES_PER_ROAD + (lane))
+#define MAX_SCENARIO_LINE 256
+#define MAX_LINE_VALUES (SCENARIO_LANES_PER_ROAD + 1) // "arrivals A 1 1 1"
+
+// File header. Valid only for the source file it was compiled from, as
+// identified by its size and modification time.
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int scenarioSize;
+    unsigned long long sourceSize;
+    long long sourceSeconds;
+    long long sourceNanoseconds;
+} ScenarioCacheHeader;
+
+// Turns of the original hand-written layout, in the order it chose between
+// them. Lane 1 of every road and A3 have none.
+static const unsigned char defaultTurns[][2] = {
+    {SLOT(0, 1), SLOT(1, 1)}, {SLOT(0, 1), SLOT(3, 1)},
+    {SLOT(1, 2), SLOT(2, 0)},
+    {SLOT(1, 1), SLOT(0, 1)}, {SLOT(1, 1), SLOT(2, 1)},
+    {SLOT(2, 2), SLOT(1, 0)},
+    {SLOT(2, 1), SLOT(0, 1)}, {SLOT(2, 1), SLOT(3, 1)},
+    {SLOT(3, 2), SLOT(0, 0)},
+    {SLOT(3, 1), SLOT(2, 1)}, {SLOT(3, 1), SLOT(1, 1)},
+};
+
+static void addOption(WeightedChoice* choice, int option, unsigned int weight) {
+    unsigned int before = choice->count > 0 ? choice->cumulative[choice->count - 1] : 0;
+    choice->option[choice->count] = (unsigned char)option;
+    choice->cumulative[choice->count] = before + weight;
+    choice->count++;
+}
+
+// The built-in junction: every lane equally likely for a new vehicle and
+// an even split between the turns of each lane
+void defaultScenario(Scenario* scenario) {
+    memset(scenario, 0, sizeof(*scenario));
+    scenario->laneWidth = SCENARIO_DEFAULT_LANE_WIDTH;
+    scenario->ticksPerSecond = JUNCTION_DEFAULT_TICKS_PER_SECOND;
+    defaultSignalPlan(&scenario->plan);
+    scenario->promoteThreshold = QUEUE_SIZE / 2;
+    for (int road = 0; road < SCENARIO_ROADS; road++) {
+        for (int lane = 0; lane < SCENARIO_LANES_PER_ROAD; lane++) {
+            addOption(&scenario->routing.arrivalLane[road], lane, 1);
+        }
+    }
+    for (size_t i = 0; i < sizeof(defaultTurns) / sizeof(defaultTurns[0]); i++) {
+        addOption(&scenario->routing.turn[defaultTurns[i][0]], defaultTurns[i][1], 1);
+    }
+}
+
+// Option chosen with probability proportional to its weight, -1 if there
+// are none. A single option is taken without drawing a random number. The
+// number comes from rand_r(seed), or from rand() when seed is NULL.
+int pickWeighted(const WeightedChoice* choice, unsigned int* seed) {
+    if (choice->count == 0) return -1;
+    if (choice->count == 1) return choice->option[0];
+    unsigned int r = (unsigned int)(seed ? rand_r(seed) : rand()) % choice->cumulative[choice->count - 1];
+    int k = 0;
+    while (choice->cumulative[k] <= r) k++;
+    return choice->option[k];
+}
+
+static bool parseNumber(const char* text, long min, long max, int* value) {
+    char* end;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed < min || parsed > max) return false;
+    *value = (int)parsed;
+    return true;
+}
+
+static bool parseRoadName(const char* text, int* road) {
+    if (text[0] < 'A' || text[0] >= 'A' + SCENARIO_ROADS || text[1] != '\0') return false;
+    *road = text[0] - 'A';
+    return true;
+}
+
+// Road letter and lane number, e.g. "A2"
+static bool parseLaneName(const char* text, int* slot) {
+    char road;
+    int lane, used = 0;
+    if (sscanf(text, "%c%d%n", &road, &lane, &used) != 2 || text[used] != '\0' ||
+        road < 'A' || road >= 'A' + SCENARIO_ROADS || lane < 1 || lane > SCENARIO_LANES_PER_ROAD) {
+        return false;
+    }
+    *slot = SLOT(road - 'A', lane - 1);
+    return true;
+}
+
+// Applies one line of a scenario file. Returns NULL, or what was wrong.
+static const char* applyLine(Scenario* scenario, bool* turnsGiven, char* line) {
+    char* comment = strchr(line, '#');
+    if (comment) *comment = '\0';
+    char* key = strtok(line, " \t\r\n");
+    if (key == NULL) return NULL;
+    char* values[MAX_LINE_VALUES];
+    int count = 0;
+    for (char* token = strtok(NULL, " \t\r\n"); token; token = strtok(NULL, " \t\r\n")) {
+        if (count == MAX_LINE_VALUES) return "too many values";
+        values[count++] = token;
+    }
+
+    if (strcmp(key, "lane-width") == 0) {
+        if (count != 1 || !parseNumber(values[0], SCENARIO_MIN_LANE_WIDTH, SCENARIO_MAX_LANE_WIDTH, &scenario->laneWidth) ||
+            scenario->laneWidth % 2 != 0) {
+            return "lane-width takes an even number of world units from 10 to 100";
+        }
+    } else if (strcmp(key, "ticks-per-second") == 0) {
+        if (count != 1 || !parseNumber(values[0], 1, 1000, &scenario->ticksPerSecond)) {
+            return "ticks-per-second takes a number from 1 to 1000";
+        }
+    } else if (strcmp(key, "signal-plan") == 0) {
+        if (count != 1 || !parseSignalPlan(values[0], &scenario->plan)) return "signal-plan takes phases such as A:5,C:5";
+    } else if (strcmp(key, "priority-lanes") == 0) {
+        if (count != 1 || !parseLaneList(values[0], &scenario->priorityLanes)) return "priority-lanes takes lanes such as A2,C1";
+    } else if (strcmp(key, "promote-after") == 0) {
+        if (count != 1 || !parseNumber(values[0], 0, INT_MAX, &scenario->promoteThreshold)) {
+            return "promote-after takes a number of waiting vehicles";
+        }
+    } else if (strcmp(key, "arrivals") == 0) {
+        // Weight of each lane of a road for new vehicles, lane 1 first
+        int road, weights[SCENARIO_LANES_PER_ROAD];
+        if (count != 1 + SCENARIO_LANES_PER_ROAD || !parseRoadName(values[0], &road)) {
+            return "arrivals takes a road and one weight per lane";
+        }
+        for (int lane = 0; lane < SCENARIO_LANES_PER_ROAD; lane++) {
+            if (!parseNumber(values[1 + lane], 0, SCENARIO_MAX_WEIGHT, &weights[lane])) return "arrivals has an invalid weight";
+        }
+        WeightedChoice* choice = &scenario->routing.arrivalLane[road];
+        memset(choice, 0, sizeof(*choice));
+        for (int lane = 0; lane < SCENARIO_LANES_PER_ROAD; lane++) {
+            if (weights[lane] > 0) addOption(choice, lane, (unsigned int)weights[lane]);
+        }
+    } else if (strcmp(key, "turn") == 0) {
+        // The first turn replaces the built-in ones; options keep file order
+        int from, to, weight;
+        if (count != 3 || !parseLaneName(values[0], &from) || !parseLaneName(values[1], &to) ||
+            !parseNumber(values[2], 1, SCENARIO_MAX_WEIGHT, &weight)) {
+            return "turn takes a source lane, a destination lane and a weight";
+        }
+        if (!*turnsGiven) {
+            memset(scenario->routing.turn, 0, sizeof(scenario->routing.turn));
+            *turnsGiven = true;
+        }
+        WeightedChoice* choice = &scenario->routing.turn[from];
+        for (int k = 0; k < choice->count; k++) {
+            if (choice->option[k] == to) return "turn is given twice";
+        }
+        addOption(choice, to, (unsigned int)weight);
+    } else {
+        return "unknown setting";
+    }
+    return NULL;
+}
+
+// Reads a scenario file over the built-in junction. Settings it leaves out
+// keep their defaults.
+bool compileScenario(const char* path, Scenario* scenario) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror("Error opening scenario file");
+        return false;
+    }
+    defaultScenario(scenario);
+    char line[MAX_SCENARIO_LINE];
+    bool turnsGiven = false;
+    int number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        number++;
+        const char* error = applyLine(scenario, &turnsGiven, line);
+        if (error) {
+            printf("Error: %s line %d: %s\n", path, number, error);
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static bool readScenarioCache(const char* cachePath, const ScenarioCacheHeader* expected, Scenario* scenario) {
+    FILE* file = fopen(cachePath, "rb");
+    if (!file) return false;
+    ScenarioCacheHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(&header, expected, sizeof(header)) == 0 &&
+              fread(scenario, sizeof(*scenario), 1, file) == 1;
+    fclose(file);
+    return ok;
+}
+
+// Written to a temporary file and renamed, so a reader never sees half a cache
+static void writeScenarioCache(const char* cachePath, const ScenarioCacheHeader* header, const Scenario* scenario) {
+    char tempPath[520];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", cachePath);
+    FILE* file = fopen(tempPath, "wb");
+    if (!file) {
+        printf("Warning: could not write scenario cache %s\n", cachePath);
+        return;
+    }
+    bool ok = fwrite(header, sizeof(*header), 1, file) == 1 && fwrite(scenario, sizeof(*scenario), 1, file) == 1;
+    if (fclose(file) != 0) ok = false;
+    if (!ok || rename(tempPath, cachePath) != 0) {
+        printf("Warning: could not write scenario cache %s\n", cachePath);
+        unlink(tempPath);
+    }
+}
+
+// Compiled scenario from "<path>.bin" when that was built from the file as
+// it is now, otherwise compiles the file and rewrites the cache
+bool loadScenario(const char* path, Scenario* scenario) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        perror("Error opening scenario file");
+        return false;
+    }
+    ScenarioCacheHeader header;
+    memset(&header, 0, sizeof(header));  // Padding is compared too
+    header.magic = SCENARIO_CACHE_MAGIC;
+    header.version = SCENARIO_CACHE_VERSION;
+    header.scenarioSize = sizeof(Scenario);
+    header.sourceSize = (unsigned long long)info.st_size;
+    header.sourceSeconds = (long long)info.st_mtim.tv_sec;
+    header.sourceNanoseconds = (long long)info.st_mtim.tv_nsec;
+
+    char cachePath[512];
+    snprintf(cachePath, sizeof(cachePath), "%s.bin", path);
+    if (readScenarioCache(cachePath, &header, scenario)) return true;
+    if (!compileScenario(path, scenario)) return false;
+    writeScenarioCache(cachePath, &header, scenario);
+    return true;
+}
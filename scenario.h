@@ -0,0 +1,49 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+#include <stdbool.h>
+#include "signalPlan.h"
+
+#define SCENARIO_ROADS 4
+#define SCENARIO_LANES_PER_ROAD 3
+#define SCENARIO_LANE_SLOTS (SCENARIO_ROADS * SCENARIO_LANES_PER_ROAD) // road * lanes + lane
+#define SCENARIO_DEFAULT_LANE_WIDTH 50
+#define SCENARIO_MIN_LANE_WIDTH 10
+#define SCENARIO_MAX_LANE_WIDTH 100 // Keeps the roads inside the world and routes within FixedRoute
+#define SCENARIO_MAX_WEIGHT 1000000
+
+#define SCENARIO_CACHE_MAGIC 0x4E43534A // "JSCN"
+#define SCENARIO_CACHE_VERSION 1
+
+// One weighted random choice, laid out so picking is one random number and
+// a short scan of one cache line. Option k is taken when
+// cumulative[k - 1] <= r < cumulative[k] for r = rand() % total.
+typedef struct {
+    int count;                                    // Options, 0 => nothing to choose
+    unsigned char option[SCENARIO_LANE_SLOTS];    // Lane index or lane slot
+    unsigned int cumulative[SCENARIO_LANE_SLOTS]; // Running weight totals
+} WeightedChoice;
+
+// Where vehicles go: the lane a new vehicle joins on each road, and the
+// turning ratios out of each lane
+typedef struct {
+    WeightedChoice arrivalLane[SCENARIO_ROADS];   // Options are lane indices
+    WeightedChoice turn[SCENARIO_LANE_SLOTS];     // Options are destination lane slots
+} ScenarioRouting;
+
+// A junction layout compiled from a scenario file. Holds no pointers, so
+// it is written to and read from the binary cache as it is.
+typedef struct {
+    int laneWidth;          // World units; even, so lane centres are whole units
+    int ticksPerSecond;
+    SignalPlan plan;
+    unsigned int priorityLanes;
+    int promoteThreshold;
+    ScenarioRouting routing;
+} Scenario;
+
+void defaultScenario(Scenario* scenario);
+bool compileScenario(const char* path, Scenario* scenario);
+bool loadScenario(const char* path, Scenario* scenario);
+int pickWeighted(const WeightedChoice* choice, unsigned int* seed);
+
+#endif
@@ -0,0 +1,150 @@
+#include "sharedState.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static unsigned long alignUp(unsigned long size) {
+    return (size + SHARED_STATE_ALIGN - 1) / SHARED_STATE_ALIGN * SHARED_STATE_ALIGN;
+}
+
+static SharedStateSlot* slotAt(const SharedStateHeader* header, unsigned int index) {
+    return (SharedStateSlot*)((char*)header + header->headerSize + (unsigned long)index * header->slotSize);
+}
+
+// Creates the region afresh, so readers never map a half-sized one left by
+// an earlier run. Others may only read it.
+bool openSharedStatePublisher(SharedStatePublisher* publisher, const char* name, int vehicleCapacity,
+                              int ticksPerSecond, int laneWidth) {
+    memset(publisher, 0, sizeof(*publisher));
+    if (vehicleCapacity <= 0) vehicleCapacity = SHARED_STATE_DEFAULT_VEHICLES;
+    unsigned long headerSize = alignUp(sizeof(SharedStateHeader));
+    unsigned long slotSize = alignUp(sizeof(SharedStateSlot) + (unsigned long)vehicleCapacity * sizeof(SharedStateVehicle));
+    unsigned long size = headerSize + SHARED_STATE_SLOTS * slotSize;
+
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        perror("Error creating shared state");
+        return false;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        perror("Error sizing shared state");
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+    void* region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        perror("Error mapping shared state");
+        shm_unlink(name);
+        return false;
+    }
+
+    // The new pages are zero: every slot is empty and at sequence 0
+    SharedStateHeader* header = (SharedStateHeader*)region;
+    header->version = SHARED_STATE_VERSION;
+    header->headerSize = (unsigned int)headerSize;
+    header->slotSize = (unsigned int)slotSize;
+    header->vehicleRecordSize = sizeof(SharedStateVehicle);
+    header->vehicleCapacity = vehicleCapacity;
+    header->ticksPerSecond = ticksPerSecond;
+    header->laneWidth = laneWidth;
+    atomic_store_explicit(&header->latest, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    header->magic = SHARED_STATE_MAGIC;
+
+    snprintf(publisher->name, sizeof(publisher->name), "%s", name);
+    publisher->header = header;
+    publisher->size = size;
+    publisher->next = 1;
+    return true;
+}
+
+// Marks the next slot as being written and returns it for the caller to
+// fill, with no more than header->vehicleCapacity vehicles
+SharedStateSlot* beginSharedStateWrite(SharedStatePublisher* publisher) {
+    SharedStateSlot* slot = slotAt(publisher->header, (unsigned int)publisher->next);
+    unsigned long long sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);  // Odd sequence is seen before any of the new contents
+    return slot;
+}
+
+// Closes the slot and makes it the one readers start from
+void publishSharedState(SharedStatePublisher* publisher, SharedStateSlot* slot) {
+    unsigned long long sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_release);
+    atomic_store_explicit(&publisher->header->latest, (unsigned int)publisher->next, memory_order_release);
+    publisher->next = (publisher->next + 1) % SHARED_STATE_SLOTS;
+}
+
+// Removes the name; readers that still have it mapped keep the last tick
+void closeSharedStatePublisher(SharedStatePublisher* publisher) {
+    if (publisher->header == NULL) return;
+    munmap(publisher->header, publisher->size);
+    shm_unlink(publisher->name);
+    publisher->header = NULL;
+}
+
+bool openSharedStateReader(SharedStateReader* reader, const char* name) {
+    memset(reader, 0, sizeof(*reader));
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        perror("Error opening shared state");
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (unsigned long)info.st_size < sizeof(SharedStateHeader)) {
+        printf("Error: shared state %s is not ready\n", name);
+        close(fd);
+        return false;
+    }
+    void* region = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        perror("Error mapping shared state");
+        return false;
+    }
+
+    const SharedStateHeader* header = (const SharedStateHeader*)region;
+    bool valid = header->magic == SHARED_STATE_MAGIC;
+    atomic_thread_fence(memory_order_acquire);
+    if (!valid || header->version != SHARED_STATE_VERSION ||
+        header->vehicleRecordSize != sizeof(SharedStateVehicle) ||
+        header->headerSize + (unsigned long)SHARED_STATE_SLOTS * header->slotSize > (unsigned long)info.st_size) {
+        printf("Error: %s is not a junction shared state of version %d\n", name, SHARED_STATE_VERSION);
+        munmap(region, (size_t)info.st_size);
+        return false;
+    }
+    reader->header = header;
+    reader->size = (unsigned long)info.st_size;
+    return true;
+}
+
+// The latest slot, read in place. Everything read from it is only valid
+// if endSharedStateRead then returns true; otherwise start again. Clamp
+// vehicleCount to header->vehicleCapacity before indexing, since a torn
+// read can see any value.
+const SharedStateSlot* beginSharedStateRead(const SharedStateReader* reader, unsigned long long* sequence) {
+    SharedStateHeader* header = (SharedStateHeader*)reader->header;
+    unsigned int latest = atomic_load_explicit(&header->latest, memory_order_acquire) % SHARED_STATE_SLOTS;
+    SharedStateSlot* slot = slotAt(header, latest);
+    *sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    return slot;
+}
+
+bool endSharedStateRead(const SharedStateSlot* slot, unsigned long long sequence) {
+    atomic_thread_fence(memory_order_acquire);  // Every read of the contents happens before the check
+    unsigned long long now = atomic_load_explicit(&((SharedStateSlot*)slot)->sequence, memory_order_relaxed);
+    return sequence % 2 == 0 && sequence != 0 && now == sequence;
+}
+
+void closeSharedStateReader(SharedStateReader* reader) {
+    if (reader->header == NULL) return;
+    munmap((void*)reader->header, reader->size);
+    reader->header = NULL;
+}
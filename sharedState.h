@@ -0,0 +1,81 @@
+#ifndef SHAREDSTATE_H
+#define SHAREDSTATE_H
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define SHARED_STATE_MAGIC 0x4D48534A // "JSHM"
+#define SHARED_STATE_VERSION 1
+#define SHARED_STATE_SLOTS 2
+#define SHARED_STATE_ROADS 4
+#define SHARED_STATE_LANES_PER_ROAD 3
+#define SHARED_STATE_PLATE_SIZE 8
+#define SHARED_STATE_DEFAULT_VEHICLES 16384 // In-flight vehicles a slot holds unless asked otherwise
+#define SHARED_STATE_ALIGN 64               // Header and slots start on their own cache lines
+
+// Layout of the region, which is all that readers in other processes
+// depend on. Only sizes fixed on every Linux target are used, and the
+// header gives the record and slot sizes so a reader can check them.
+
+// One vehicle crossing the junction
+typedef struct {
+    unsigned long long id;               // Packed plate, as junctionPlateId
+    char plate[SHARED_STATE_PLATE_SIZE]; // Padded with NULs; not terminated at full length
+    float x, y;                          // World position after the tick
+    unsigned char road, lane;            // Where it came from
+    unsigned char destRoad, destLane;    // Where it is going
+    unsigned int waitTicks;              // Ticks it waited in its lane queue
+} SharedStateVehicle;
+
+// The world after one tick. `sequence` is odd while the writer is inside
+// the slot; a read is consistent when it was even before and unchanged after.
+typedef struct {
+    atomic_ullong sequence;
+    unsigned long long tick;
+    int greenRoad;                // Road the signal plan has green
+    unsigned int flowing;         // Bit per road whose vehicles may enter: green or not signal controlled
+    int laneCounts[SHARED_STATE_ROADS][SHARED_STATE_LANES_PER_ROAD];
+    int inFlight;                 // Vehicles crossing; more than vehicleCount when capacity ran out
+    int vehicleCount;             // Records in vehicles
+    SharedStateVehicle vehicles[];
+} SharedStateSlot;
+
+typedef struct {
+    unsigned int magic;           // Written last, once the rest is valid
+    unsigned int version;
+    unsigned int headerSize;      // Bytes before the first slot
+    unsigned int slotSize;        // Bytes from one slot to the next
+    unsigned int vehicleRecordSize;
+    int vehicleCapacity;          // Records each slot has room for
+    int ticksPerSecond;
+    int laneWidth;
+    atomic_uint latest;           // Slot written most recently
+} SharedStateHeader;
+
+// Writer side, owned by the simulation thread. Ticks go to the two slots
+// in turn, so a reader of the latest one is only disturbed if it is still
+// reading it two ticks later.
+typedef struct {
+    char name[256];
+    SharedStateHeader* header;
+    unsigned long size;
+    int next;                     // Slot the next tick goes to
+} SharedStatePublisher;
+
+// Reader side, any number of processes. The region is mapped read-only.
+typedef struct {
+    const SharedStateHeader* header;
+    unsigned long size;
+} SharedStateReader;
+
+bool openSharedStatePublisher(SharedStatePublisher* publisher, const char* name, int vehicleCapacity,
+                              int ticksPerSecond, int laneWidth);
+SharedStateSlot* beginSharedStateWrite(SharedStatePublisher* publisher);
+void publishSharedState(SharedStatePublisher* publisher, SharedStateSlot* slot);
+void closeSharedStatePublisher(SharedStatePublisher* publisher);
+
+bool openSharedStateReader(SharedStateReader* reader, const char* name);
+const SharedStateSlot* beginSharedStateRead(const SharedStateReader* reader, unsigned long long* sequence);
+bool endSharedStateRead(const SharedStateSlot* slot, unsigned long long sequence);
+void closeSharedStateReader(SharedStateReader* reader);
+
+#endif
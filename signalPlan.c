@@ -0,0 +1,73 @@
+#include "signalPlan.h"
+#include "junction.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Road A and road C, 5 seconds each
+void defaultSignalPlan(SignalPlan* plan) {
+    plan->phaseCount = 2;
+    plan->phaseRoad[0] = 0;
+    plan->phaseSeconds[0] = 5;
+    plan->phaseRoad[1] = 2;
+    plan->phaseSeconds[1] = 5;
+}
+
+// Parses "A:5,C:5" style plans: road letter and green time in seconds
+bool parseSignalPlan(const char* text, SignalPlan* plan) {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    plan->phaseCount = 0;
+
+    for (char* phase = strtok(buffer, ","); phase; phase = strtok(NULL, ",")) {
+        char road;
+        double seconds;
+        if (sscanf(phase, " %c:%lf", &road, &seconds) != 2 ||
+            road < 'A' || road >= 'A' + JUNCTION_ROADS || seconds <= 0) {
+            printf("Invalid signal phase: %s\n", phase);
+            return false;
+        }
+        if (plan->phaseCount == MAX_SIGNAL_PHASES) {
+            printf("Signal plan has more than %d phases\n", MAX_SIGNAL_PHASES);
+            return false;
+        }
+        plan->phaseRoad[plan->phaseCount] = road - 'A';
+        plan->phaseSeconds[plan->phaseCount] = seconds;
+        plan->phaseCount++;
+    }
+    return plan->phaseCount > 0;
+}
+
+void formatSignalPlan(const SignalPlan* plan, char* buffer, int size) {
+    int used = 0;
+    buffer[0] = '\0';
+    for (int i = 0; i < plan->phaseCount && used < size; i++) {
+        used += snprintf(buffer + used, size - used, "%s%c:%g", i > 0 ? ";" : "",
+                         'A' + plan->phaseRoad[i], plan->phaseSeconds[i]);
+    }
+}
+
+// Road that is green on the given tick. Derived from the tick alone, so a
+// run resumed from a checkpoint or replayed lands on the same phase.
+int signalPlanLight(const SignalPlan* plan, unsigned long long tick, int ticksPerSecond) {
+    unsigned long long cycle = 0;
+    for (int i = 0; i < plan->phaseCount; i++) {
+        cycle += (unsigned long long)(plan->phaseSeconds[i] * ticksPerSecond);
+    }
+    if (cycle == 0) return plan->phaseCount > 0 ? plan->phaseRoad[0] : 0;
+
+    unsigned long long offset = tick % cycle;
+    for (int i = 0; i < plan->phaseCount; i++) {
+        unsigned long long length = (unsigned long long)(plan->phaseSeconds[i] * ticksPerSecond);
+        if (offset < length) return plan->phaseRoad[i];
+        offset -= length;
+    }
+    return plan->phaseRoad[plan->phaseCount - 1];
+}
+
+bool signalPlanControls(const SignalPlan* plan, int roadIndex) {
+    for (int i = 0; i < plan->phaseCount; i++) {
+        if (plan->phaseRoad[i] == roadIndex) return true;
+    }
+    return false;
+}
@@ -0,0 +1,22 @@
+#ifndef SIGNALPLAN_H
+#define SIGNALPLAN_H
+#include <stdbool.h>
+
+#define MAX_SIGNAL_PHASES 8
+
+// Fixed-time signal plan: each phase gives one road green for a number of
+// seconds, then the plan moves on and wraps around. Roads that no phase
+// mentions are not signal controlled and always flow.
+typedef struct {
+    int phaseCount;
+    int phaseRoad[MAX_SIGNAL_PHASES];
+    double phaseSeconds[MAX_SIGNAL_PHASES];
+} SignalPlan;
+
+void defaultSignalPlan(SignalPlan* plan);
+bool parseSignalPlan(const char* text, SignalPlan* plan);
+void formatSignalPlan(const SignalPlan* plan, char* buffer, int size);
+int signalPlanLight(const SignalPlan* plan, unsigned long long tick, int ticksPerSecond);
+bool signalPlanControls(const SignalPlan* plan, int roadIndex);
+
+#endif
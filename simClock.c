@@ -0,0 +1,146 @@
+#include "simClock.h"
+#include <time.h>
+#include <errno.h>
+
+double monotonicSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static double clampSpeed(double speed) {
+    if (speed <= SIM_CLOCK_UNLIMITED) return SIM_CLOCK_UNLIMITED;
+    if (speed < SIM_CLOCK_MIN_SPEED) return SIM_CLOCK_MIN_SPEED;
+    if (speed > SIM_CLOCK_MAX_SPEED) return SIM_CLOCK_MAX_SPEED;
+    return speed;
+}
+
+void initSimClock(SimClock* clock, int ticksPerSecond, double speed, unsigned long long startTick) {
+    clock->ticksPerSecond = ticksPerSecond;
+    atomic_init(&clock->tick, startTick);
+    pthread_mutex_init(&clock->lock, NULL);
+
+    // Timed waits are measured on the same clock as monotonicSeconds
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&clock->changed, &attr);
+    pthread_condattr_destroy(&attr);
+
+    clock->speed = clampSpeed(speed);
+    clock->wallAnchor = monotonicSeconds();
+    clock->tickAnchor = startTick;
+    clock->waiters = 0;
+    clock->slippedSeconds = 0;
+    clock->stopped = false;
+}
+
+void destroySimClock(SimClock* clock) {
+    pthread_cond_destroy(&clock->changed);
+    pthread_mutex_destroy(&clock->lock);
+}
+
+// Simulated time of the last completed tick, in seconds
+double simClockSeconds(SimClock* clock) {
+    return (double)atomic_load(&clock->tick) / clock->ticksPerSecond;
+}
+
+double simClockSpeed(SimClock* clock) {
+    pthread_mutex_lock(&clock->lock);
+    double speed = clock->speed;
+    pthread_mutex_unlock(&clock->lock);
+    return speed;
+}
+
+// Takes effect from the current tick on; the ticks themselves are unchanged,
+// so traffic behaves the same at any speed
+void simClockSetSpeed(SimClock* clock, double speed) {
+    pthread_mutex_lock(&clock->lock);
+    clock->speed = clampSpeed(speed);
+    clock->wallAnchor = monotonicSeconds();
+    clock->tickAnchor = atomic_load(&clock->tick);
+    pthread_cond_broadcast(&clock->changed);
+    pthread_mutex_unlock(&clock->lock);
+}
+
+// Wall-clock length of one tick at the current speed, 0 when unlimited
+double simClockTickWallSeconds(SimClock* clock) {
+    double speed = simClockSpeed(clock);
+    if (speed == SIM_CLOCK_UNLIMITED) return 0;
+    return 1.0 / (clock->ticksPerSecond * speed);
+}
+
+static struct timespec toTimespec(double seconds) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - ts.tv_sec) * 1e9);
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+// Called by the simulation thread once `tick` is complete. Publishes it and
+// blocks until the next tick is due. A speed change wakes it early so the
+// new speed applies straight away.
+//
+// Ticks are due on a fixed schedule from the anchor, so a late tick is made
+// up by running the next ones back to back and the long-run rate is exact.
+// Past SIM_CLOCK_MAX_LAG behind, e.g. after the process was suspended, the
+// backlog is given up instead and the schedule restarts from now.
+void simClockPaceTick(SimClock* clock, unsigned long long tick) {
+    atomic_store(&clock->tick, tick);
+
+    pthread_mutex_lock(&clock->lock);
+    if (clock->waiters > 0) pthread_cond_broadcast(&clock->changed);
+    while (!clock->stopped && clock->speed != SIM_CLOCK_UNLIMITED) {
+        double due = clock->wallAnchor +
+                     (double)(tick + 1 - clock->tickAnchor) / (clock->ticksPerSecond * clock->speed);
+        double now = monotonicSeconds();
+        if (now >= due) {
+            if (now - due > SIM_CLOCK_MAX_LAG) {
+                clock->slippedSeconds += (now - due) * clock->speed;
+                clock->wallAnchor = now;
+                clock->tickAnchor = tick;
+            }
+            break;
+        }
+        struct timespec deadline = toTimespec(due);
+        pthread_cond_timedwait(&clock->changed, &clock->lock, &deadline);
+    }
+    pthread_mutex_unlock(&clock->lock);
+}
+
+// Simulated seconds dropped so far because the simulation fell too far behind
+double simClockSlippedSeconds(SimClock* clock) {
+    pthread_mutex_lock(&clock->lock);
+    double slipped = clock->slippedSeconds;
+    pthread_mutex_unlock(&clock->lock);
+    return slipped;
+}
+
+// Blocks until `simSeconds` of simulated time have passed. Returns false if
+// the clock was stopped first.
+bool simClockSleep(SimClock* clock, double simSeconds) {
+    unsigned long long until = atomic_load(&clock->tick) +
+                               (unsigned long long)(simSeconds * clock->ticksPerSecond);
+
+    pthread_mutex_lock(&clock->lock);
+    clock->waiters++;
+    while (!clock->stopped && atomic_load(&clock->tick) < until) {
+        pthread_cond_wait(&clock->changed, &clock->lock);
+    }
+    clock->waiters--;
+    bool stopped = clock->stopped;
+    pthread_mutex_unlock(&clock->lock);
+    return !stopped;
+}
+
+// Releases every thread waiting on the clock
+void simClockStop(SimClock* clock) {
+    pthread_mutex_lock(&clock->lock);
+    clock->stopped = true;
+    pthread_cond_broadcast(&clock->changed);
+    pthread_mutex_unlock(&clock->lock);
+}
@@ -0,0 +1,42 @@
+#ifndef SIMCLOCK_H
+#define SIMCLOCK_H
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define SIM_CLOCK_UNLIMITED 0.0  // Speed factor: step as fast as the CPU allows
+#define SIM_CLOCK_MIN_SPEED 0.1
+#define SIM_CLOCK_MAX_SPEED 64.0
+#define SIM_CLOCK_MAX_LAG 0.25   // Wall seconds the simulation may run behind before it stops catching up
+
+// The one source of simulated time. The simulation thread advances it a
+// tick at a time and is paced against the wall clock by the speed factor;
+// every other thread reads or waits on simulated time instead of calling
+// sleep() with wall-clock durations.
+typedef struct {
+    int ticksPerSecond;
+    atomic_ullong tick;        // Last completed tick
+    pthread_mutex_t lock;
+    pthread_cond_t changed;    // Tick advanced, speed changed or clock stopped
+    double speed;              // Simulated seconds per wall second, 0 => unlimited
+    double wallAnchor;         // Wall time at which tickAnchor was reached
+    unsigned long long tickAnchor;
+    int waiters;               // Threads blocked in simClockSleep
+    double slippedSeconds;     // Simulated time given up after falling too far behind
+    bool stopped;
+} SimClock;
+
+double monotonicSeconds(void);
+
+void initSimClock(SimClock* clock, int ticksPerSecond, double speed, unsigned long long startTick);
+void destroySimClock(SimClock* clock);
+double simClockSeconds(SimClock* clock);
+double simClockSpeed(SimClock* clock);
+void simClockSetSpeed(SimClock* clock, double speed);
+double simClockTickWallSeconds(SimClock* clock);
+void simClockPaceTick(SimClock* clock, unsigned long long tick);
+double simClockSlippedSeconds(SimClock* clock);
+bool simClockSleep(SimClock* clock, double simSeconds);
+void simClockStop(SimClock* clock);
+
+#endif
@@ -1,83 +1,111 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <time.h>
+
+#include "junction.h"
+#include "simClock.h"
+#include "snapshot.h"
+#include "snapshot.c"
+#include "renderBatch.h"
+#include "renderBatch.c"
+#include "camera.h"
+#include "camera.c"
+#include "heatmap.h"
+#include "heatmap.c"
+#include "frameExport.h"
+#include "frameExport.c"
+#include "ingest.h"
+#include "ingest.c"
+#include "sweep.h"
+#include "sweep.c"
+#include "soak.h"
+#include "soak.c"
 
-#include "dataManagement.h"
-#include "dataManagement.c"
-
-#define MAX_LINE_LENGTH 20
 #define MAIN_FONT "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf"
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 800
 #define SCALE 1
-#define ROAD_WIDTH 150
-#define LANE_WIDTH 50
+#define WORLD_SIZE JUNCTION_WORLD_SIZE
 #define ARROW_SIZE 15
-#define QUEUE_SIZE 10
-#define MAX_ROADS 4
-#define MAX_VEHICLE_QUEUE_SIZE 15
-#define MAX_LANE_SIZE 3
 #define VEHICLE_WIDTH 30
 #define VEHICLE_HEIGHT 20
-#define VEHICLE_SPEED 2
+#define LIGHT_BOX_LONG 50        // Traffic light box, along and across its road edge
+#define LIGHT_BOX_SHORT 30
+#define DEFAULT_CHECKPOINT_SECONDS 10
+#define FRAME_SECONDS (1.0 / 60)    // Target frame interval
+#define ZOOM_STEP 1.25f          // Zoom per mouse wheel notch
+#define PAN_STEP 50              // Pixels per arrow key press
+#define LABEL_MIN_ZOOM 0.6f      // Below this plates are not drawn
+#define DENSITY_MIN_ZOOM 0.25f   // Below this vehicles are drawn as density cells
+#define DENSITY_MAX_VEHICLES 4000 // Above this many on screen, likewise
 
 const char* VEHICLE_FILE = "vehicles.data";
 
 typedef struct {
-    Vehicle vehicle;
-    SDL_Rect rect;
-    float x, y;           // Precise position for smooth movement
-    float targetX, targetY; // Target position
-    bool isMoving;
-    bool hasArrived;
-    int pathStep;         // Current step in the path
-} VehicleUI;
-
-typedef struct{
-    int currentLight;
-    int nextLight;
-} SharedData;
-
-typedef struct{
-    SharedData sharedData;
-    int greenDuration;
-    int redDuration;
-}TrafficLight;
-typedef struct {
-    Road* roads[MAX_ROADS];
+    Junction* junction;
 } ThreadData;
 
-VehicleUI activeVehicles[200];
-int vehicleCount = 0;
+// Settings taken from the command line
+typedef struct {
+    JunctionConfig junction;    // Admission limits, threads, signal plan, priority lanes
+    const char* checkpointPath; // NULL => no periodic checkpoints
+    int checkpointSeconds;
+    const char* restorePath;    // NULL => start with an empty junction
+    const char* recordPath;     // NULL => do not record inputs
+    const char* replayPath;     // NULL => live input from the vehicle file
+    const char* sharedName;     // NULL => no shared memory state for other processes
+    int sharedVehicles;         // In-flight vehicles shared per tick, 0 => default
+    double speed;               // Simulated seconds per wall second, 0 => unlimited
+    const char* trackPlate;     // NULL => no vehicle highlighted
+    bool heatmap;               // Start with the congestion heatmap shown
+    int ingestWorkers;          // Threads parsing the vehicle file
+    const char* exportDirectory; // NULL => frames are only shown in the window
+    int exportFormat;           // FRAME_FORMAT_*
+    int exportEvery;            // Export every Nth frame
+    unsigned long exportCount;  // Close after this many exported frames, 0 => when the window closes
+    bool sweep;                 // Run the parameter sweep instead of the window
+    SweepConfig sweepConfig;
+    bool soak;                  // Run the end-to-end soak test instead of the window
+    SoakConfig soakConfig;
+} SimOptions;
+
+SimOptions options;
+TripleBuffer snapshots;
+SimClock simClock;
+atomic_bool simulationRunning = true;
 
 
 // Function declarations
 
-void initializeRoads(Road* roads[MAX_ROADS]);
 bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer);
-void drawRoadsAndLane(SDL_Renderer *renderer, TTF_Font *font, Road* roads[MAX_ROADS]);
-void displayText(SDL_Renderer *renderer, TTF_Font *font, char *text, int x, int y);
-void drawLightForA(SDL_Renderer* renderer, bool isRed);
-void drawLightForB(SDL_Renderer* renderer, bool isRed);
-void drawLightForC(SDL_Renderer* renderer, bool isRed);
-void drawLightForD(SDL_Renderer* renderer, bool isRed);
-void refreshLight(SDL_Renderer *renderer, SharedData* sharedData);
-void* chequeQueue(void* arg);
+void drawRoadsAndLane(FrameBatch* frame, const Camera* camera, Junction* junction);
+void displayText(FrameBatch* frame, const char *text, int x, int y);
+void displayWorldText(FrameBatch* frame, const Camera* camera, const char* text, float x, float y);
+void drawLightForA(GeometryBatch* shapes, const Camera* camera, int laneWidth, bool isRed);
+void drawLightForB(GeometryBatch* shapes, const Camera* camera, int laneWidth, bool isRed);
+void drawLightForC(GeometryBatch* shapes, const Camera* camera, int laneWidth, bool isRed);
+void drawLightForD(GeometryBatch* shapes, const Camera* camera, int laneWidth, bool isRed);
 void* readAndParseFile(void* arg);
-void calculatePath(Lane* sourceLane, Lane* destLane, int pathX[4], int pathY[4], int* numPoints, Road* roads[MAX_ROADS]);
-void getLaneCoordinates(Lane* lane, int* startX, int* startY, int* endX, int* endY, Road* roads[MAX_ROADS]);
 SDL_Color getVehicleColor(const char* vehicleName);
-void addVehicleToUI(Vehicle vehicle, Road* roads[MAX_ROADS]);
-void updateVehiclesPosition(Road* roads[MAX_ROADS]);
-void renderVehicles(SDL_Renderer* renderer, TTF_Font* font);
-void processVehicleQueues(Road* roads[MAX_ROADS], bool trafficLightStatus[MAX_ROADS]);
-void updateTrafficLightStatus(bool trafficLightStatus[MAX_ROADS], SharedData* sharedData);
+void renderVehicles(FrameBatch* frame, const Camera* camera, const SimSnapshot* snapshot, float alpha);
+bool handleCameraEvent(Camera* camera, const SDL_Event* event);
+bool parseOptions(int argc, char* argv[], SimOptions* options);
+void* runSimulation(void* arg);
+bool runHeadlessTrial(const SweepTrial* trial, SweepResult* result);
+int runSoakTest(void);
+void writeSnapshot(Junction* junction);
+void formatSpeed(double speed, char* buffer, int size);
+void formatTracked(Junction* junction, const JunctionVehicleLookup* tracked, char* buffer, int size);
+void printWaitSummary(Junction* junction);
 
 
 
@@ -89,17 +117,65 @@ void printMessageHelper(const char* message, int count) {
     for (int i = 0; i < count; i++) printf("%s\n", message);
 }
 
-int main() {
-    pthread_t tQueue, tReadFile;
+int main(int argc, char* argv[]) {
+    pthread_t tReadFile, tSimulation;
     SDL_Window* window = NULL;
     SDL_Renderer* renderer = NULL;
     SDL_Event event;
-    bool trafficLightStatus[MAX_ROADS] = {true, false, false, false}; // Start with road A having green light
     ThreadData threadData;
+
+    if (!parseOptions(argc, argv, &options)) {
+        printf("Usage: %s [--max-active N] [--max-release-per-tick N] [--threads N]\n"
+               "          [--checkpoint FILE] [--checkpoint-every SECONDS] [--restore FILE]\n"
+               "          [--record FILE | --replay FILE] [--scenario FILE] [--signal-plan A:5,C:5] [--speed X|unlimited]\n"
+               "          [--priority-lanes A2,...] [--promote-after N] [--track PLATE] [--fixed-point]\n"
+               "          [--ingest-workers N] [--heatmap] [--shm NAME [--shm-vehicles N]]\n"
+               "          [--export DIR [--export-format ppm|raw|png] [--export-every N] [--export-count N]]\n"
+               "          [--sweep [--sweep-green S,...] [--sweep-rates N,...] [--sweep-seeds N]\n"
+               "           [--sweep-duration SECONDS] [--jobs N] [--sweep-out FILE]]\n"
+               "          [--soak [--soak-rate N] [--soak-duration SECONDS] [--soak-report SECONDS]\n"
+               "           [--soak-file FILE] [--soak-out FILE]]\n", argv[0]);
+        return -1;
+    }
+    // Sweeps fork one process per trial, so they run before any thread exists
+    if (options.sweep) {
+        return runSweep(&options.sweepConfig, runHeadlessTrial);
+    }
+    if (options.soak) {
+        return runSoakTest();
+    }
+    printf("Admission policy: max active %d, max release per tick %d (0 = unlimited)\n",
+           options.junction.maxActive, options.junction.maxReleasePerTick);
     
-    // Initialize roads
-    initializeRoads(threadData.roads);
-    printf("Roads initialized\n");
+    // The junction model lives in libjunction; this program only feeds and draws it
+    Junction* junction = junctionCreate(&options.junction);
+    if (!junction) {
+        return -1;
+    }
+    threadData.junction = junction;
+    printf("Junction initialized\n");
+    
+    // Resume where the last run left off
+    if (options.restorePath && !junctionRestore(junction, options.restorePath)) {
+        printf("Failed to restore checkpoint %s\n", options.restorePath);
+        return -1;
+    }
+    if (options.checkpointPath &&
+        !junctionStartCheckpoints(junction, options.checkpointPath, options.checkpointSeconds)) {
+        return -1;
+    }
+    if (options.recordPath && !junctionStartRecording(junction, options.recordPath)) {
+        return -1;
+    }
+    if (options.replayPath && !junctionStartReplay(junction, options.replayPath)) {
+        return -1;
+    }
+    if (options.sharedName) {
+        if (!junctionStartSharedState(junction, options.sharedName, options.sharedVehicles)) return -1;
+        printf("Publishing state to shared memory %s\n", options.sharedName);
+    }
+    // Every thread below takes its time from this clock
+    initSimClock(&simClock, junctionTicksPerSecond(junction), options.speed, junctionTick(junction));
     
     // Initialize SDL and SDL_ttf
     if (!initializeSDL(&window, &renderer)) {
@@ -116,73 +192,526 @@ int main() {
     }
     printf("Font loaded\n");
     
-    // Initialize shared data
-    SharedData sharedData = { 0, 0 }; // 0 => Road A has green light
+    // Everything is drawn through two batches: shapes, then text from the glyph atlas
+    FrameBatch frame;
+    initGeometryBatch(&frame.shapes);
+    initGeometryBatch(&frame.text);
+    if (!initGlyphAtlas(&frame.atlas, renderer, font)) {
+        printf("Failed to build glyph atlas\n");
+        return -1;
+    }
     
-    // Create threads
-    pthread_create(&tQueue, NULL, chequeQueue, &sharedData);
-    printf("Traffic light thread created\n");
+    initTripleBuffer(&snapshots);
     
-    pthread_create(&tReadFile, NULL, readAndParseFile, (void*)&threadData);
-    printf("File reading thread created\n");
+    // Create threads. A replay supplies its own arrivals.
+    if (!options.replayPath) {
+        pthread_create(&tReadFile, NULL, readAndParseFile, (void*)&threadData);
+        printf("File reading thread created\n");
+    }
     
-    // Main loop
+    pthread_create(&tSimulation, NULL, runSimulation, (void*)&threadData);
+    printf("Simulation thread created\n");
+    
+    // The window starts showing the whole junction
+    Camera camera;
+    initCamera(&camera, WINDOW_WIDTH, WINDOW_HEIGHT, WORLD_SIZE);
+    
+    // Congestion builds up from the start; h shows or hides it
+    Heatmap heatmap;
+    if (!initHeatmap(&heatmap, renderer, junction)) {
+        return -1;
+    }
+    bool showHeatmap = options.heatmap;
+    
+    // Exported frames are drawn into an offscreen texture of fixed size,
+    // read back into the exporter's buffers and then shown in the window
+    FrameExporter exporter;
+    SDL_Texture* exportTarget = NULL;
+    unsigned long frameIndex = 0, exportedFrames = 0;
+    if (options.exportDirectory) {
+        exportTarget = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                         WINDOW_WIDTH, WINDOW_HEIGHT);
+        if (!exportTarget) {
+            printf("Failed to create export target: %s\n", SDL_GetError());
+            return -1;
+        }
+        if (!startFrameExport(&exporter, options.exportDirectory, options.exportFormat,
+                              WINDOW_WIDTH, WINDOW_HEIGHT)) {
+            return -1;
+        }
+        printf("Exporting every %d frame(s) to %s\n", options.exportEvery, options.exportDirectory);
+    }
+    
+    // Main loop: only draws the latest snapshot, the simulation runs on its own thread
     bool running = true;
-    Uint32 lastTime = SDL_GetTicks();
+    double nextFrame = monotonicSeconds();
     
     while (running) {
+        // Sleep until the next frame is due; input wakes us early
+        double now = monotonicSeconds();
+        int waitMs = now < nextFrame ? (int)ceil((nextFrame - now) * 1000) : 0;
+        
         // Process SDL events
-        while (SDL_PollEvent(&event)) {
+        for (bool hasEvent = SDL_WaitEventTimeout(&event, waitMs); hasEvent; hasEvent = SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) running = false;
+            if (exportTarget && event.type == SDL_WINDOWEVENT) continue; // Exported frames keep their size
+            if (handleCameraEvent(&camera, &event)) continue;
+            
+            // Time compression: + and - double or halve it, 1 resets it, u removes the limit
+            if (event.type == SDL_KEYDOWN) {
+                double speed = simClockSpeed(&simClock);
+                switch (event.key.keysym.sym) {
+                    case SDLK_PLUS: case SDLK_EQUALS: case SDLK_KP_PLUS:
+                        if (speed != SIM_CLOCK_UNLIMITED) simClockSetSpeed(&simClock, speed * 2);
+                        break;
+                    case SDLK_MINUS: case SDLK_KP_MINUS:
+                        simClockSetSpeed(&simClock, speed == SIM_CLOCK_UNLIMITED ? SIM_CLOCK_MAX_SPEED : speed / 2);
+                        break;
+                    case SDLK_1: simClockSetSpeed(&simClock, 1.0); break;
+                    case SDLK_u: simClockSetSpeed(&simClock, SIM_CLOCK_UNLIMITED); break;
+                    case SDLK_h: showHeatmap = !showHeatmap; break;
+                }
+            }
         }
         
-        // Update light status
-        refreshLight(renderer, &sharedData);
+        // Frames are due on a fixed 60 Hz schedule. Drawing only shows the
+        // latest snapshot, so a missed frame is skipped rather than made up.
+        now = monotonicSeconds();
+        if (now < nextFrame) continue;
+        nextFrame += FRAME_SECONDS;
+        if (nextFrame < now) nextFrame = now + FRAME_SECONDS;
         
-        // Frame timing for 60 fps
-        Uint32 currentTime = SDL_GetTicks();
-        if (currentTime - lastTime >= 16) {
-            // Update traffic light statuses
-            updateTrafficLightStatus(trafficLightStatus, &sharedData);
-            
-            // Process vehicle queues based on traffic lights
-            processVehicleQueues(threadData.roads, trafficLightStatus);
-            
-            // Update vehicle positions
-            updateVehiclesPosition(threadData.roads);
-            
-            // Clear screen and redraw everything
-            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-            SDL_RenderClear(renderer);
-            
-            // Redraw roads, lanes, vehicles, etc.
-            drawRoadsAndLane(renderer, font, threadData.roads);
-            
-            // Draw traffic lights
-            drawLightForA(renderer, sharedData.currentLight != 0);
-            drawLightForB(renderer, sharedData.currentLight != 1);
-            drawLightForC(renderer, sharedData.currentLight != 2);
-            drawLightForD(renderer, sharedData.currentLight != 3);
-            
-            // Draw vehicles
-            renderVehicles(renderer, font);
-            
-            // Present the rendered frame
-            SDL_RenderPresent(renderer);
-            
-            lastTime = currentTime;
+        const SimSnapshot* snapshot = acquireLatestSnapshot(&snapshots);
+        updateHeatmap(&heatmap, snapshot);
+        
+        // How far we are between the previous tick and the next one
+        float alpha = 1.0f;
+        if (snapshot->tickSeconds > 0) {
+            alpha = (float)((monotonicSeconds() - snapshot->publishedAt) / snapshot->tickSeconds);
+            if (alpha < 0.0f) alpha = 0.0f;
+            if (alpha > 1.0f) alpha = 1.0f;
         }
+        
+        // Clear screen and redraw everything
+        if (exportTarget) SDL_SetRenderTarget(renderer, exportTarget);
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        SDL_RenderClear(renderer);
+        
+        // Redraw roads, lanes, vehicles, etc.
+        drawRoadsAndLane(&frame, &camera, junction);
+        
+        // Draw traffic lights
+        int laneWidth = junctionLaneWidth(junction);
+        drawLightForA(&frame.shapes, &camera, laneWidth, snapshot->currentLight != 0);
+        drawLightForB(&frame.shapes, &camera, laneWidth, snapshot->currentLight != 1);
+        drawLightForC(&frame.shapes, &camera, laneWidth, snapshot->currentLight != 2);
+        drawLightForD(&frame.shapes, &camera, laneWidth, snapshot->currentLight != 3);
+        
+        // The heatmap goes over the roads and under the vehicles, so the
+        // shapes so far are submitted first
+        if (showHeatmap) {
+            flushGeometryBatch(renderer, &frame.shapes, NULL);
+            drawHeatmap(&heatmap, renderer, &camera);
+        }
+        
+        // Draw vehicles
+        renderVehicles(&frame, &camera, snapshot, alpha);
+        
+        // Current time compression in the corner
+        char speedText[32];
+        formatSpeed(simClockSpeed(&simClock), speedText, sizeof(speedText));
+        displayText(&frame, speedText, 10, 10);
+        
+        // Where the tracked vehicle is right now
+        if (options.trackPlate) {
+            char trackText[96];
+            formatTracked(junction, &snapshot->tracked, trackText, sizeof(trackText));
+            displayText(&frame, trackText, 10, 40);
+        }
+        
+        // Submit the rest of the frame: one call for shapes, one for text
+        flushGeometryBatch(renderer, &frame.shapes, NULL);
+        flushGeometryBatch(renderer, &frame.text, frame.atlas.texture);
+        
+        // Hand every Nth frame to the writer thread. If all its buffers are
+        // still queued the frame is skipped, so the disk never holds us up.
+        if (exportTarget) {
+            frameIndex++;
+            if (frameIndex % options.exportEvery == 0) {
+                int buffer = acquireExportBuffer(&exporter);
+                if (buffer >= 0) {
+                    if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGB24, exporter.buffers[buffer],
+                                             WINDOW_WIDTH * 3) == 0) {
+                        submitExportFrame(&exporter, buffer, frameIndex / options.exportEvery);
+                        exportedFrames++;
+                    } else {
+                        printf("Failed to read frame: %s\n", SDL_GetError());
+                        releaseExportBuffer(&exporter, buffer);
+                    }
+                }
+                if (options.exportCount > 0 && frameIndex / options.exportEvery >= options.exportCount) {
+                    running = false;
+                }
+            }
+            SDL_SetRenderTarget(renderer, NULL);
+            SDL_RenderCopy(renderer, exportTarget, NULL, NULL);
+        }
+        
+        // Present the rendered frame
+        SDL_RenderPresent(renderer);
+    }
+    
+    atomic_store(&simulationRunning, false);
+    simClockStop(&simClock); // Wakes the simulation and file threads if they are waiting
+    pthread_join(tSimulation, NULL);
+    if (!options.replayPath) pthread_join(tReadFile, NULL); // It may be submitting into the junction
+    if (simClockSlippedSeconds(&simClock) > 0) {
+        printf("Simulation fell behind and skipped %.2f simulated seconds\n", simClockSlippedSeconds(&simClock));
     }
     
     // Cleanup
+    if (exportTarget) {
+        stopFrameExport(&exporter); // Writes the frames still queued
+        SDL_DestroyTexture(exportTarget);
+    }
+    freeHeatmap(&heatmap);
+    freeGlyphAtlas(&frame.atlas);
+    freeGeometryBatch(&frame.text);
+    freeGeometryBatch(&frame.shapes);
     if (renderer) SDL_DestroyRenderer(renderer);
     if (window) SDL_DestroyWindow(window);
     TTF_CloseFont(font);
     TTF_Quit();
     SDL_Quit();
+    freeTripleBuffer(&snapshots);
+    printWaitSummary(junction);
+    junctionDestroy(junction); // Also flushes the last checkpoint and closes the replay log
     
     return 0;
 }
+
+// Mouse wheel zooms at the cursor, dragging or the arrow keys pan, Home
+// shows the whole junction again. Returns true if the event was used.
+bool handleCameraEvent(Camera* camera, const SDL_Event* event) {
+    switch (event->type) {
+        case SDL_MOUSEWHEEL: {
+            int mouseX, mouseY;
+            SDL_GetMouseState(&mouseX, &mouseY);
+            if (event->wheel.y != 0) cameraZoomAt(camera, event->wheel.y > 0 ? ZOOM_STEP : 1 / ZOOM_STEP, mouseX, mouseY);
+            return true;
+        }
+        case SDL_MOUSEMOTION:
+            if (!(event->motion.state & SDL_BUTTON_LMASK)) return false;
+            cameraPan(camera, event->motion.xrel, event->motion.yrel);
+            return true;
+        case SDL_WINDOWEVENT:
+            if (event->window.event != SDL_WINDOWEVENT_SIZE_CHANGED) return false;
+            cameraResize(camera, event->window.data1 / SCALE, event->window.data2 / SCALE);
+            return true;
+        case SDL_KEYDOWN:
+            switch (event->key.keysym.sym) {
+                case SDLK_LEFT: cameraPan(camera, PAN_STEP, 0); return true;
+                case SDLK_RIGHT: cameraPan(camera, -PAN_STEP, 0); return true;
+                case SDLK_UP: cameraPan(camera, 0, PAN_STEP); return true;
+                case SDLK_DOWN: cameraPan(camera, 0, -PAN_STEP); return true;
+                case SDLK_HOME: initCamera(camera, camera->viewWidth, camera->viewHeight, WORLD_SIZE); return true;
+            }
+            return false;
+    }
+    return false;
+}
+
+// "x4", "x0.5" or "unlimited"
+void formatSpeed(double speed, char* buffer, int size) {
+    if (speed == SIM_CLOCK_UNLIMITED) snprintf(buffer, size, "unlimited");
+    else snprintf(buffer, size, "x%g", speed);
+}
+
+// "AB1CD234: Road A lane 2, 3 ahead", "AB1CD234: crossing" or "AB1CD234: not in the junction"
+void formatTracked(Junction* junction, const JunctionVehicleLookup* tracked, char* buffer, int size) {
+    const JunctionVehicle* vehicle = &tracked->vehicle;
+    if (tracked->state == JUNCTION_QUEUED) {
+        snprintf(buffer, size, "%s: %s lane %d, %d ahead", options.trackPlate,
+                 junctionRoadName(junction, vehicle->road), vehicle->lane + 1, tracked->queuePosition);
+    } else if (tracked->state == JUNCTION_IN_FLIGHT) {
+        snprintf(buffer, size, "%s: crossing", options.trackPlate);
+    } else {
+        snprintf(buffer, size, "%s: not in the junction", options.trackPlate);
+    }
+}
+
+// Queue wait per road and overall, printed when the window closes
+void printWaitSummary(Junction* junction) {
+    JunctionWaitStats stats;
+    printf("Queue wait (s)   vehicles    mean     p50     p95     p99     max\n");
+    for (int road = -1; road < JUNCTION_ROADS; road++) {
+        junctionGetWaitStats(junction, road, -1, &stats);
+        printf("%-15s %9llu %7.1f %7.1f %7.1f %7.1f %7.1f\n", road < 0 ? "All roads" : junctionRoadName(junction, road),
+               stats.count, stats.mean, stats.p50, stats.p95, stats.p99, stats.max);
+    }
+}
+
+// Simulation thread: steps the junction and publishes a snapshot after
+// every tick, paced by the simulation clock. It never waits on the renderer.
+void* runSimulation(void* arg) {
+    ThreadData* data = (ThreadData*)arg;
+    Junction* junction = data->junction;
+    bool replaying = junctionReplaying(junction);
+    double replayStarted = monotonicSeconds();
+
+    // Replays run flat out, then continue at the chosen speed
+    if (replaying) simClockSetSpeed(&simClock, SIM_CLOCK_UNLIMITED);
+
+    while (atomic_load(&simulationRunning)) {
+        junctionStep(junction);
+        writeSnapshot(junction);
+        
+        if (replaying && !junctionReplaying(junction)) {
+            replaying = false;
+            printf("Replay took %.2f s\n", monotonicSeconds() - replayStarted);
+            simClockSetSpeed(&simClock, options.speed);
+        }
+        simClockPaceTick(&simClock, junctionTick(junction));
+    }
+    return NULL;
+}
+
+// Sweep trial: a private junction fed by seeded random arrivals, stepped as
+// fast as possible with no window. Runs in its own process.
+bool runHeadlessTrial(const SweepTrial* trial, SweepResult* result) {
+    JunctionConfig config = options.junction;
+    config.plan = trial->plan;
+    config.workerThreads = 1;
+    Junction* junction = junctionCreate(&config);
+    if (!junction) return false;
+
+    int ticksPerSecond = junctionTicksPerSecond(junction);
+    unsigned long long ticks = (unsigned long long)(trial->durationSeconds * ticksPerSecond);
+    double perTick = trial->arrivalRate / 60.0 / ticksPerSecond;
+    double started = monotonicSeconds();
+    srand(trial->seed);
+
+    for (unsigned long long tick = 1; tick <= ticks; tick++) {
+        // Poisson arrivals: count events until the uniform product drops below e^-rate
+        double limit = exp(-perTick), product = rand() / (RAND_MAX + 1.0);
+        while (product > limit) {
+            char plate[JUNCTION_PLATE_SIZE + 1];
+            for (int i = 0; i < JUNCTION_PLATE_SIZE; i++) {
+                plate[i] = (i == 2 || i >= 5) ? '0' + rand() % 10 : 'A' + rand() % 26;
+            }
+            plate[JUNCTION_PLATE_SIZE] = '\0';
+            junctionSubmitArrival(junction, plate, rand() % JUNCTION_ROADS);
+            product *= rand() / (RAND_MAX + 1.0);
+        }
+        junctionStep(junction);
+    }
+
+    JunctionStats stats;
+    junctionGetStats(junction, &stats);
+    result->arrived = stats.arrived;
+    result->dropped = stats.dropped;
+    result->released = stats.released;
+    result->departed = stats.departed;
+    result->totalDelaySeconds = (double)stats.totalDelayTicks / ticksPerSecond;
+    result->maxDelaySeconds = (double)stats.maxDelayTicks / ticksPerSecond;
+    result->wallSeconds = monotonicSeconds() - started;
+    result->ticksPerSecond = ticksPerSecond;
+    junctionGetWaitHistogram(junction, -1, -1, &result->waits);
+
+    junctionDestroy(junction);
+    return true;
+}
+
+// Soak test: the live pipeline (vehicle file, reader thread, simulation
+// thread, snapshots) with a generator in place of traffic_generator and
+// the monitor in place of the window. Runs for a fixed wall-clock time.
+int runSoakTest(void) {
+    SoakConfig* config = &options.soakConfig;
+    VEHICLE_FILE = config->vehiclePath;
+    FILE* file = fopen(VEHICLE_FILE, "w");  // Start from an empty file
+    if (!file) {
+        perror("Error creating soak vehicle file");
+        return -1;
+    }
+    fclose(file);
+
+    Junction* junction = junctionCreate(&options.junction);
+    if (!junction) return -1;
+    ThreadData data = {junction};
+    initSimClock(&simClock, junctionTicksPerSecond(junction), options.speed, 0);
+    initTripleBuffer(&snapshots);
+
+    SoakMonitor monitor;
+    if (!startSoak(&monitor, config, junctionTicksPerSecond(junction))) return -1;
+    pthread_t reader, simulation;
+    pthread_create(&reader, NULL, readAndParseFile, &data);
+    pthread_create(&simulation, NULL, runSimulation, &data);
+    printf("Soak test: %.0f vehicles per minute for %.0f s, report every %.0f s to %s\n",
+           config->ratePerMinute, config->durationSeconds, config->reportSeconds, config->outputPath);
+
+    double nextReport = monitor.startedAt + config->reportSeconds;
+    double end = monitor.startedAt + config->durationSeconds;
+    const SimSnapshot* snapshot = acquireLatestSnapshot(&snapshots);
+    while (monotonicSeconds() < end) {
+        usleep(SOAK_OBSERVE_MICROSECONDS);
+        snapshot = acquireLatestSnapshot(&snapshots);
+        observeSoakSnapshot(&monitor, snapshot);
+        if (monotonicSeconds() >= nextReport) {
+            writeSoakReport(&monitor, snapshot);
+            nextReport += config->reportSeconds;
+        }
+    }
+    stopSoak(&monitor);
+
+    atomic_store(&simulationRunning, false);
+    simClockStop(&simClock);  // Wakes both threads
+    pthread_join(simulation, NULL);
+    pthread_join(reader, NULL);
+    junctionDestroy(junction);
+    freeTripleBuffer(&snapshots);
+    destroySimClock(&simClock);
+    return 0;
+}
+
+// Copies everything the renderer needs into the writer's slot and publishes it
+void writeSnapshot(Junction* junction) {
+    SimSnapshot* snapshot = beginSnapshotWrite(&snapshots, junctionVehicleCount(junction));
+    if (snapshot == NULL) return;
+
+    snapshot->tick = junctionTick(junction);
+    snapshot->tickSeconds = simClockTickWallSeconds(&simClock);
+    snapshot->currentLight = junctionGreenRoad(junction);
+    for (int i = 0; i < JUNCTION_ROADS; i++) {
+        for (int j = 0; j < JUNCTION_LANES_PER_ROAD; j++) {
+            snapshot->laneCounts[i][j] = junctionQueueLength(junction, i, j);
+        }
+    }
+    junctionGetVehicles(junction, snapshots.unsorted, snapshot->vehicleCount);
+    binSnapshotVehicles(&snapshots, snapshot);
+    if (options.trackPlate) {
+        junctionFindVehicle(junction, junctionPlateId(options.trackPlate), &snapshot->tracked);
+    }
+    snapshot->publishedAt = monotonicSeconds();
+    publishSnapshot(&snapshots);
+}
+
+
+// Reads the simulator settings from the command line
+bool parseOptions(int argc, char* argv[], SimOptions* options) {
+    memset(options, 0, sizeof(*options));
+    junctionDefaultConfig(&options->junction); // No limits unless asked for on the command line
+    options->checkpointSeconds = DEFAULT_CHECKPOINT_SECONDS;
+    options->speed = 1.0;
+    options->exportEvery = 1;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    options->ingestWorkers = cores > 0 ? (int)cores : 1;
+    JunctionConfig* junction = &options->junction;
+    SweepConfig* sweep = &options->sweepConfig;
+    initSweepConfig(sweep);
+    SoakConfig* soak = &options->soakConfig;
+    initSoakConfig(soak);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-active") == 0 && i + 1 < argc) {
+            junction->maxActive = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-release-per-tick") == 0 && i + 1 < argc) {
+            junction->maxReleasePerTick = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            junction->workerThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            options->checkpointPath = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            options->checkpointSeconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) {
+            options->restorePath = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            options->recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options->replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            options->sharedName = argv[++i];
+        } else if (strcmp(argv[i], "--shm-vehicles") == 0 && i + 1 < argc) {
+            options->sharedVehicles = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            i++;
+            options->speed = strcmp(argv[i], "unlimited") == 0 ? SIM_CLOCK_UNLIMITED : atof(argv[i]);
+            if (options->speed != SIM_CLOCK_UNLIMITED && options->speed < SIM_CLOCK_MIN_SPEED) {
+                printf("--speed must be at least %g, or \"unlimited\"\n", SIM_CLOCK_MIN_SPEED);
+                return false;
+            }
+        } else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            if (!junctionLoadScenario(argv[++i], junction)) return false;
+            sweep->plan = junction->plan;
+        } else if (strcmp(argv[i], "--signal-plan") == 0 && i + 1 < argc) {
+            if (!parseSignalPlan(argv[++i], &junction->plan)) return false;
+            sweep->plan = junction->plan;
+        } else if (strcmp(argv[i], "--priority-lanes") == 0 && i + 1 < argc) {
+            if (!junctionParseLanes(argv[++i], &junction->priorityLanes)) return false;
+        } else if (strcmp(argv[i], "--promote-after") == 0 && i + 1 < argc) {
+            junction->promoteThreshold = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fixed-point") == 0) {
+            junction->fixedPoint = true;
+        } else if (strcmp(argv[i], "--ingest-workers") == 0 && i + 1 < argc) {
+            options->ingestWorkers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--track") == 0 && i + 1 < argc) {
+            options->trackPlate = argv[++i];
+        } else if (strcmp(argv[i], "--heatmap") == 0) {
+            options->heatmap = true;
+        } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            options->exportDirectory = argv[++i];
+        } else if (strcmp(argv[i], "--export-format") == 0 && i + 1 < argc) {
+            if (!parseFrameFormat(argv[++i], &options->exportFormat)) return false;
+        } else if (strcmp(argv[i], "--export-every") == 0 && i + 1 < argc) {
+            options->exportEvery = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--export-count") == 0 && i + 1 < argc) {
+            options->exportCount = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+            options->sweep = true;
+        } else if (strcmp(argv[i], "--sweep-green") == 0 && i + 1 < argc) {
+            if (!parseSweepValues(argv[++i], sweep->greenSeconds, &sweep->greenCount)) return false;
+        } else if (strcmp(argv[i], "--sweep-rates") == 0 && i + 1 < argc) {
+            if (!parseSweepValues(argv[++i], sweep->arrivalRates, &sweep->rateCount)) return false;
+        } else if (strcmp(argv[i], "--sweep-seeds") == 0 && i + 1 < argc) {
+            sweep->seeds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sweep-duration") == 0 && i + 1 < argc) {
+            sweep->durationSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            sweep->jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sweep-out") == 0 && i + 1 < argc) {
+            sweep->outputPath = argv[++i];
+        } else if (strcmp(argv[i], "--soak") == 0) {
+            options->soak = true;
+        } else if (strcmp(argv[i], "--soak-rate") == 0 && i + 1 < argc) {
+            soak->ratePerMinute = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--soak-duration") == 0 && i + 1 < argc) {
+            soak->durationSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--soak-report") == 0 && i + 1 < argc) {
+            soak->reportSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--soak-file") == 0 && i + 1 < argc) {
+            soak->vehiclePath = argv[++i];
+        } else if (strcmp(argv[i], "--soak-out") == 0 && i + 1 < argc) {
+            soak->outputPath = argv[++i];
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            return false;
+        }
+    }
+    if (options->recordPath && options->replayPath) {
+        printf("--record and --replay cannot be used together\n");
+        return false;
+    }
+    // The soak monitor times queue joins and releases from the tick length
+    if (options->soak && options->speed == SIM_CLOCK_UNLIMITED) {
+        printf("--soak cannot be used with --speed unlimited\n");
+        return false;
+    }
+    return junction->maxActive >= 0 && junction->maxReleasePerTick >= 0 &&
+           options->checkpointSeconds > 0 && junction->promoteThreshold >= 0 && options->exportEvery > 0 &&
+           options->ingestWorkers > 0 &&
+           sweep->seeds > 0 &&
+           sweep->jobs > 0 && sweep->durationSeconds > 0 &&
+           soak->ratePerMinute > 0 && soak->durationSeconds > 0 && soak->reportSeconds > 0;
+}
 bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer) {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
@@ -198,14 +727,20 @@ bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer) {
     *window = SDL_CreateWindow("Junction Diagram",
                                SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                                WINDOW_WIDTH*SCALE, WINDOW_HEIGHT*SCALE,
-                               SDL_WINDOW_SHOWN);
+                               SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
     if (!*window) {
         SDL_Log("Failed to create window: %s", SDL_GetError());
         SDL_Quit();
         return false;
     }
 
-    *renderer = SDL_CreateRenderer(*window, -1, SDL_RENDERER_ACCELERATED);
+    *renderer = SDL_CreateRenderer(*window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC |
+                                                 SDL_RENDERER_TARGETTEXTURE);
+    if (!*renderer) {
+        // No GPU, e.g. SDL_VIDEODRIVER=offscreen or dummy on a headless host
+        SDL_Log("No accelerated renderer (%s), using the software renderer", SDL_GetError());
+        *renderer = SDL_CreateRenderer(*window, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE);
+    }
     // if you have high resolution monitor 2K or 4K then scale
     SDL_RenderSetScale(*renderer, SCALE, SCALE);
 
@@ -221,195 +756,117 @@ bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer) {
 }
 
 
-void swap(int *a, int *b) {
-    int temp = *a;
-    *a = *b;
-    *b = temp;
+// Lamp colour for a light, shared by the lamp square and its arrow
+SDL_Color lightColor(bool isRed) {
+    if (isRed) return (SDL_Color){255, 0, 0, 255};
+    return (SDL_Color){11, 156, 50, 255};
 }
 
-
-void drawArrow(SDL_Renderer* renderer, int x1, int y1, int x2, int y2, int x3, int y3) {
-    // Sort vertices by ascending Y (bubble sort approach)
-    if (y1 > y2) { swap(&y1, &y2); swap(&x1, &x2); }
-    if (y1 > y3) { swap(&y1, &y3); swap(&x1, &x3); }
-    if (y2 > y3) { swap(&y2, &y3); swap(&x2, &x3); }
-
-    // Compute slopes
-    float dx1 = (y2 - y1) ? (float)(x2 - x1) / (y2 - y1) : 0;
-    float dx2 = (y3 - y1) ? (float)(x3 - x1) / (y3 - y1) : 0;
-    float dx3 = (y3 - y2) ? (float)(x3 - x2) / (y3 - y2) : 0;
-
-    float sx1 = x1, sx2 = x1;
-
-    // Fill first part (top to middle)
-    for (int y = y1; y < y2; y++) {
-        SDL_RenderDrawLine(renderer, (int)sx1, y, (int)sx2, y);
-        sx1 += dx1;
-        sx2 += dx2;
-    }
-
-    sx1 = x2;
-
-    // Fill second part (middle to bottom)
-    for (int y = y2; y <= y3; y++) {
-        SDL_RenderDrawLine(renderer, (int)sx1, y, (int)sx2, y);
-        sx1 += dx3;
-        sx2 += dx2;
-    }
-}
-
- void drawLightForA(SDL_Renderer* renderer, bool isRed){
+// Each light box straddles the edge of its road where vehicles stop, with
+// its long side across the road's centre line. The box keeps its size;
+// only its place follows the lane width, as the roads do.
+void drawLightForA(GeometryBatch* shapes, const Camera* camera, int laneWidth, bool isRed){
+    float half = laneWidth * JUNCTION_LANES_PER_ROAD / 2.0f;
+    float x = WORLD_SIZE / 2 - LIGHT_BOX_LONG / 2, y = WORLD_SIZE / 2 + half - 25;
     // draw light box
-       SDL_SetRenderDrawColor(renderer, 150, 150, 150, 255);
-    SDL_Rect lightBox = {375, 450, 50, 30};  
-    SDL_RenderFillRect(renderer, &lightBox);
+    cameraFillRect(shapes, camera, x, y, LIGHT_BOX_LONG, LIGHT_BOX_SHORT, (SDL_Color){150, 150, 150, 255});
 
-    if(isRed) SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); 
-    else SDL_SetRenderDrawColor(renderer, 11, 156, 50, 255);    
-    SDL_Rect straight_Light = {400, 455, 20, 20};
-    SDL_RenderFillRect(renderer, &straight_Light);
+    SDL_Color lamp = lightColor(isRed);
+    cameraFillRect(shapes, camera, x + 25, y + 5, 20, 20, lamp);
 
-    drawArrow(renderer, 380+10, 455, 380+10, 455+20, 380, 455+10);
+    cameraTriangle(shapes, camera, x + 15, y + 5, x + 15, y + 25, x + 5, y + 15, lamp);
 }
-void drawLightForB(SDL_Renderer* renderer, bool isRed){
+void drawLightForB(GeometryBatch* shapes, const Camera* camera, int laneWidth, bool isRed){
+    float half = laneWidth * JUNCTION_LANES_PER_ROAD / 2.0f;
+    float x = WORLD_SIZE / 2 - LIGHT_BOX_LONG / 2, y = WORLD_SIZE / 2 - half - 25;
     // draw light box
-    SDL_SetRenderDrawColor(renderer, 150, 150, 150, 255);
-    SDL_Rect lightBox = {375, 300, 50, 30};
-    SDL_RenderFillRect(renderer, &lightBox);
-    if(isRed) SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); 
-    else SDL_SetRenderDrawColor(renderer, 11, 156, 50, 255);    
-    SDL_Rect straight_Light = {380, 305, 20, 20};
-    SDL_RenderFillRect(renderer, &straight_Light);
-    drawArrow(renderer, 410,305, 410, 305+20, 410+10, 305+10);
+    cameraFillRect(shapes, camera, x, y, LIGHT_BOX_LONG, LIGHT_BOX_SHORT, (SDL_Color){150, 150, 150, 255});
+    SDL_Color lamp = lightColor(isRed);
+    cameraFillRect(shapes, camera, x + 5, y + 5, 20, 20, lamp);
+    cameraTriangle(shapes, camera, x + 35, y + 5, x + 35, y + 25, x + 45, y + 15, lamp);
 }
 
-void drawLightForC(SDL_Renderer* renderer, bool isRed){
-    SDL_SetRenderDrawColor(renderer, 150, 150, 150, 255);
-    SDL_Rect lightBox = {320, 375, 30, 50};  // Adjust position for road D
-    SDL_RenderFillRect(renderer, &lightBox);
+void drawLightForC(GeometryBatch* shapes, const Camera* camera, int laneWidth, bool isRed){
+    float half = laneWidth * JUNCTION_LANES_PER_ROAD / 2.0f;
+    float x = WORLD_SIZE / 2 - half - 5, y = WORLD_SIZE / 2 - LIGHT_BOX_LONG / 2;
+    cameraFillRect(shapes, camera, x, y, LIGHT_BOX_SHORT, LIGHT_BOX_LONG, (SDL_Color){150, 150, 150, 255});  // Adjust position for road D
 
-    if(isRed) SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); 
-    else SDL_SetRenderDrawColor(renderer, 11, 156, 50, 255);    
-    SDL_Rect straight_Light = {325, 400, 20, 20};
-    SDL_RenderFillRect(renderer, &straight_Light);
+    SDL_Color lamp = lightColor(isRed);
+    cameraFillRect(shapes, camera, x + 5, y + 25, 20, 20, lamp);
 
-    drawArrow(renderer, 325, 380+10, 325+20, 380+10, 325+10, 380);
+    cameraTriangle(shapes, camera, x + 5, y + 15, x + 25, y + 15, x + 15, y + 5, lamp);
 }
-void drawLightForD(SDL_Renderer* renderer, bool isRed){
-      SDL_SetRenderDrawColor(renderer, 150, 150, 150, 255);
-    SDL_Rect lightBox = {450, 375, 30, 50};  // Adjust position for road C
-    SDL_RenderFillRect(renderer, &lightBox);
+void drawLightForD(GeometryBatch* shapes, const Camera* camera, int laneWidth, bool isRed){
+    float half = laneWidth * JUNCTION_LANES_PER_ROAD / 2.0f;
+    float x = WORLD_SIZE / 2 + half - 25, y = WORLD_SIZE / 2 - LIGHT_BOX_LONG / 2;
+    cameraFillRect(shapes, camera, x, y, LIGHT_BOX_SHORT, LIGHT_BOX_LONG, (SDL_Color){150, 150, 150, 255});  // Adjust position for road C
 
-    if(isRed) SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); 
-    else SDL_SetRenderDrawColor(renderer, 11, 156, 50, 255);    
-    SDL_Rect straight_Light = {455, 380, 20, 20};
-    SDL_RenderFillRect(renderer, &straight_Light);
+    SDL_Color lamp = lightColor(isRed);
+    cameraFillRect(shapes, camera, x + 5, y + 5, 20, 20, lamp);
 
-    drawArrow(renderer, 455, 405, 455+20, 405, 455+10, 405+10); // Adjust arrow direction for road C
+    cameraTriangle(shapes, camera, x + 5, y + 30, x + 25, y + 30, x + 15, y + 40, lamp); // Adjust arrow direction for road C
 }
 
 
 
-void refreshLight(SDL_Renderer *renderer, SharedData* sharedData){
-    if(sharedData->nextLight == sharedData->currentLight) return;
-
-    // Set all lights to red first
-    drawLightForA(renderer, true);  // A road light red
-    drawLightForB(renderer, true);  // B road light red
-    drawLightForC(renderer, true);  // C road light red
-    drawLightForD(renderer, true);  // D road light red
-
-    // Now set the appropriate light to green based on nextLight
-    if(sharedData->nextLight == 0) {
-        drawLightForA(renderer, false);  // A road light green
-    }
-    else if(sharedData->nextLight == 1) {
-        drawLightForB(renderer, false);  // B road light green
-    }
-    else if(sharedData->nextLight == 2) {
-        drawLightForC(renderer, false);  // C road light green
-    }
-    else if(sharedData->nextLight == 3) {
-        drawLightForD(renderer, false);  // D road light green
-    }
-
-    // Present the updated renderer
-    SDL_RenderPresent(renderer);
-
-    printf("Light of queue updated from %d to %d\n", sharedData->currentLight,  sharedData->nextLight);
-    sharedData->currentLight = sharedData->nextLight;
-    fflush(stdout);
-}
-
+void drawRoadsAndLane(FrameBatch* frame, const Camera* camera, Junction* junction) {
+    SDL_Color roadColor = {211, 211, 211, 255};
+    SDL_Color lineColor = {0, 0, 0, 255};
+    int laneWidth = junctionLaneWidth(junction);  // From the scenario
+    int roadWidth = laneWidth * JUNCTION_LANES_PER_ROAD;
 
-
-void drawRoadsAndLane(SDL_Renderer *renderer, TTF_Font *font, Road* roads[MAX_ROADS]) {
-    SDL_SetRenderDrawColor(renderer, 211,211,211,255);
     // Vertical road
-
-    SDL_Rect verticalRoad = {WINDOW_WIDTH / 2 - ROAD_WIDTH / 2, 0, ROAD_WIDTH, WINDOW_HEIGHT};
-    SDL_RenderFillRect(renderer, &verticalRoad);
+    cameraFillRect(&frame->shapes, camera, WORLD_SIZE / 2 - roadWidth / 2, 0, roadWidth, WORLD_SIZE, roadColor);
 
     // Horizontal road
-    SDL_Rect horizontalRoad = {0, WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2, WINDOW_WIDTH, ROAD_WIDTH};
-    SDL_RenderFillRect(renderer, &horizontalRoad);
+    cameraFillRect(&frame->shapes, camera, 0, WORLD_SIZE / 2 - roadWidth / 2, WORLD_SIZE, roadWidth, roadColor);
     // draw horizontal lanes
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    for(int i=0; i<=3; i++){
+    for(int i=0; i<=JUNCTION_LANES_PER_ROAD; i++){
         // Horizontal lanes
-        SDL_RenderDrawLine(renderer,
-            0, WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + LANE_WIDTH*i,  // x1,y1
-            WINDOW_WIDTH/2 - ROAD_WIDTH/2, WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + LANE_WIDTH*i // x2, y2
+        cameraDrawLine(&frame->shapes, camera,
+            0, WORLD_SIZE/2 - roadWidth/2 + laneWidth*i,  // x1,y1
+            WORLD_SIZE/2 - roadWidth/2, WORLD_SIZE/2 - roadWidth/2 + laneWidth*i, // x2, y2
+            lineColor
         );
-        SDL_RenderDrawLine(renderer,
-            800, WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + LANE_WIDTH*i,
-            WINDOW_WIDTH/2 + ROAD_WIDTH/2, WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + LANE_WIDTH*i
+        cameraDrawLine(&frame->shapes, camera,
+            WORLD_SIZE, WORLD_SIZE/2 - roadWidth/2 + laneWidth*i,
+            WORLD_SIZE/2 + roadWidth/2, WORLD_SIZE/2 - roadWidth/2 + laneWidth*i,
+            lineColor
         );
         // Vertical lanes
-        SDL_RenderDrawLine(renderer,
-            WINDOW_WIDTH/2 - ROAD_WIDTH/2 + LANE_WIDTH*i, 0,
-            WINDOW_WIDTH/2 - ROAD_WIDTH/2 + LANE_WIDTH*i, WINDOW_HEIGHT/2 - ROAD_WIDTH/2
+        cameraDrawLine(&frame->shapes, camera,
+            WORLD_SIZE/2 - roadWidth/2 + laneWidth*i, 0,
+            WORLD_SIZE/2 - roadWidth/2 + laneWidth*i, WORLD_SIZE/2 - roadWidth/2,
+            lineColor
         );
-        SDL_RenderDrawLine(renderer,
-            WINDOW_WIDTH/2 - ROAD_WIDTH/2 + LANE_WIDTH*i, 800,
-            WINDOW_WIDTH/2 - ROAD_WIDTH/2 + LANE_WIDTH*i, WINDOW_HEIGHT/2 + ROAD_WIDTH/2
+        cameraDrawLine(&frame->shapes, camera,
+            WORLD_SIZE/2 - roadWidth/2 + laneWidth*i, WORLD_SIZE,
+            WORLD_SIZE/2 - roadWidth/2 + laneWidth*i, WORLD_SIZE/2 + roadWidth/2,
+            lineColor
         );
     }
   
-    for (int i = 0; i < MAX_ROADS/2; i++) {
-        displayText(renderer, font, roads[i]->roadName, (WINDOW_WIDTH/2)-36, (WINDOW_HEIGHT*i)-(30*i)); 
+    for (int i = 0; i < JUNCTION_ROADS/2; i++) {
+        displayWorldText(frame, camera, junctionRoadName(junction, i), (WORLD_SIZE/2)-36, (WORLD_SIZE*i)-(30*i)); 
     }
-    for (int i = 0; i < MAX_ROADS/2; i++) {
-        displayText(renderer, font, roads[2+i]->roadName, (WINDOW_WIDTH*(1-i)-(96*(1-i))), (WINDOW_HEIGHT/2) - 16); 
+    for (int i = 0; i < JUNCTION_ROADS/2; i++) {
+        displayWorldText(frame, camera, junctionRoadName(junction, 2+i), (WORLD_SIZE*(1-i)-(96*(1-i))), (WORLD_SIZE/2) - 16); 
     }
 }
 
 
-void displayText(SDL_Renderer *renderer, TTF_Font *font, char *text, int x, int y){
+void displayText(FrameBatch* frame, const char *text, int x, int y){
     // display necessary text
     SDL_Color textColor = {0, 0, 0, 255}; // black color
-    SDL_Surface *textSurface = TTF_RenderText_Solid(font, text, textColor);
-    if(!textSurface){
-        SDL_Log("failed to create text surface: %s", TTF_GetError());
-    }
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, textSurface);
-     if (!texture) {
-
-        SDL_Log("Failed to create texture: %s", SDL_GetError());
-
-        SDL_FreeSurface(textSurface);
-
-        return; // Handle the error appropriately
+    batchText(&frame->text, &frame->atlas, text, x, y, textColor);
+}
 
-    }
-    SDL_FreeSurface(textSurface);
-    SDL_Rect textRect = {x,y,0,0 };
-    SDL_QueryTexture(texture, NULL, NULL, &textRect.w, &textRect.h);
-    SDL_Log("DIM of SDL_Rect %d %d %d %d", textRect.x, textRect.y, textRect.h, textRect.w);
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_Log("TTF_Error: %s\n", TTF_GetError());
-    SDL_RenderCopy(renderer, texture, NULL, &textRect);
-    // SDL_Log("TTF_Error: %s\n", TTF_GetError());
+// Text anchored to a world position; it keeps its pixel size at any zoom
+void displayWorldText(FrameBatch* frame, const Camera* camera, const char* text, float x, float y) {
+    float screenX, screenY;
+    cameraToScreen(camera, x, y, &screenX, &screenY);
+    if (screenX < -200 || screenY < -40 || screenX > camera->viewWidth || screenY > camera->viewHeight) return;
+    displayText(frame, text, (int)screenX, (int)screenY);
 }
 
 // Color mapping for vehicles
@@ -428,431 +885,109 @@ SDL_Color getVehicleColor(const char* vehicleName) {
 }
 
 
-// Get lane position in screen coordinates
-void getLaneCoordinates(Lane* lane, int* startX, int* startY, int* endX, int* endY, Road* roads[MAX_ROADS]) {
-    int roadIndex = -1;
-    int laneIndex = -1;
-    
-    // Find the road and lane index
-    for (int i = 0; i < MAX_ROADS; i++) {
-        Road* currentRoad = roads[i];
-        if (lane->road == currentRoad) {
-            roadIndex = i;
-            for (int j = 0; j < MAX_LANE_SIZE; j++) {
-                if (lane == &(currentRoad->lanes[j])) {
-                    laneIndex = j;
-                    break;
-                }
-            }
-            break;
-        }
-    }
-    
-    if (roadIndex == -1 || laneIndex == -1) {
-        // Handle error: lane not found
-        *startX = *startY = *endX = *endY = 0;
-        return;
-    }
-    
-    // Window center
-    int centerX = WINDOW_WIDTH / 2;
-    int centerY = WINDOW_HEIGHT / 2;
-    int laneOffset = LANE_WIDTH * laneIndex + LANE_WIDTH / 2;
-    
-    // Calculate based on road orientation
-    switch (roadIndex) {
-        case 0: // Road A (bottom)
-            *startX = centerX - ROAD_WIDTH / 2 + laneOffset;
-            *startY = WINDOW_HEIGHT;
-            *endX = centerX - ROAD_WIDTH / 2 + laneOffset;
-            *endY = centerY + ROAD_WIDTH / 2;
-            break;
-        case 1: // Road B (top)
-            *startX = centerX + ROAD_WIDTH / 2 - laneOffset;
-            *startY = 0;
-            *endX = centerX + ROAD_WIDTH / 2 - laneOffset;
-            *endY = centerY - ROAD_WIDTH / 2;
-            break;
-        case 2: // Road C (right)
-            *startX = WINDOW_WIDTH;
-            *startY = centerY - ROAD_WIDTH / 2 + laneOffset;
-            *endX = centerX + ROAD_WIDTH / 2;
-            *endY = centerY - ROAD_WIDTH / 2 + laneOffset;
-            break;
-        case 3: // Road D (left)
-            *startX = 0;
-            *startY = centerY + ROAD_WIDTH / 2 - laneOffset;
-            *endX = centerX - ROAD_WIDTH / 2;
-            *endY = centerY + ROAD_WIDTH / 2 - laneOffset;
-            break;
-    }
-    
+// Colour for a grid cell drawn as a block: pale when it holds a few
+// vehicles, deep red when it is packed
+SDL_Color densityColor(int count) {
+    int level = count >= 64 ? 255 : 64 + count * 3;
+    return (SDL_Color){255, (Uint8)(255 - level * 3 / 4), (Uint8)(255 - level), 255};
 }
-void calculatePath(Lane* sourceLane, Lane* destLane, int pathX[4], int pathY[4], int* numPoints, Road* roads[MAX_ROADS]) {
-    int sourceStartX, sourceStartY, sourceEndX, sourceEndY;
-    int destStartX, destStartY, destEndX, destEndY;
-    
-    getLaneCoordinates(sourceLane, &sourceStartX, &sourceStartY, &sourceEndX, &sourceEndY, roads);
-    getLaneCoordinates(destLane, &destStartX, &destStartY, &destEndX, &destEndY, roads);
-    
-    // Center of the intersection
-    int centerX = WINDOW_WIDTH / 2;
-    int centerY = WINDOW_HEIGHT / 2;
-    
-    // First point is the entry point to the intersection
-    pathX[0] = sourceEndX;
-    pathY[0] = sourceEndY;
-    
-    // Last point is the exit point from the intersection
-    pathX[3] = destStartX;
-    pathY[3] = destStartY;
-    
-    // Calculate intermediate points for a smooth curve through the intersection
-    // Find source road index
-    int sourceRoadIndex = -1;
-    int destRoadIndex = -1;
-    
-    for (int i = 0; i < MAX_ROADS; i++) {
-        if (sourceLane->road == roads[i]) sourceRoadIndex = i;
-        if (destLane->road == roads[i]) destRoadIndex = i;
-    }
-    
-    // Different path based on turn direction
-    if ((sourceRoadIndex + 2) % 4 == destRoadIndex) {
-        // Straight path through intersection
-        pathX[1] = centerX;
-        pathY[1] = centerY;
-        pathX[2] = centerX;
-        pathY[2] = centerY;
-    } else if ((sourceRoadIndex + 1) % 4 == destRoadIndex) {
-        // Right turn
-        if (sourceRoadIndex % 2 == 0) {  // Vertical road
-            pathX[1] = sourceEndX;
-            pathY[1] = centerY;
-            pathX[2] = centerX;
-            pathY[2] = destStartY;
-        } else {  // Horizontal road
-            pathX[1] = centerX;
-            pathY[1] = sourceEndY;
-            pathX[2] = destStartX;
-            pathY[2] = centerY;
-        }
-    } else if ((sourceRoadIndex + 3) % 4 == destRoadIndex) {
-        // Left turn
-        if (sourceRoadIndex % 2 == 0) {  // Vertical road
-            pathX[1] = sourceEndX;
-            pathY[1] = centerY;
-            pathX[2] = centerX;
-            pathY[2] = destStartY;
-        } else {  // Horizontal road
-            pathX[1] = centerX;
-            pathY[1] = sourceEndY;
-            pathX[2] = destStartX;
-            pathY[2] = centerY;
-        }
-    } else {
-        // U-turn (should be rare based on your destination generation logic)
-        pathX[1] = centerX;
-        pathY[1] = centerY;
-        pathX[2] = centerX;
-        pathY[2] = centerY;
-    }
-    
-    *numPoints = 4;
-}
-    void updateVehiclesPosition(Road* roads[MAX_ROADS]) {
-        printf("Updating positions for %d vehicles\n", vehicleCount);
-        
-        for (int i = 0; i < vehicleCount; i++) {
-            VehicleUI* vui = &activeVehicles[i];
-            if (!vui->isMoving || vui->hasArrived) continue;
-            
-            // Calculate direction vector
-            float dx = vui->targetX - vui->x;
-            float dy = vui->targetY - vui->y;
-            float distance = sqrt(dx*dx + dy*dy);
-            
-            printf("Vehicle %s at (%f,%f) moving to (%f,%f), distance=%f\n", 
-                   vui->vehicle.VechicleName, vui->x, vui->y, vui->targetX, vui->targetY, distance);
-            
-            if (distance < VEHICLE_SPEED) {
-                // Reached the target
-                vui->x = vui->targetX;
-                vui->y = vui->targetY;
-                vui->pathStep++;
-                
-                // Check if the vehicle has reached its final destination
-                if (vui->pathStep >= 4) {
-                    vui->hasArrived = true;
-                    vui->isMoving = false;
-                    printf("Vehicle %s has arrived at destination\n", vui->vehicle.VechicleName);
-                } else {
-                    // Set the next target in the path
-                    int pathX[4], pathY[4], numPoints;
-                    calculatePath(vui->vehicle.currentLane, vui->vehicle.destinationLane, 
-                                  pathX, pathY, &numPoints, roads);
-                    vui->targetX = pathX[vui->pathStep];
-                    vui->targetY = pathY[vui->pathStep];
-                    printf("Vehicle %s moving to next path point (%f,%f)\n", 
-                           vui->vehicle.VechicleName, vui->targetX, vui->targetY);
-                }
-            } else {
-                // Move towards the target
-                float ratio = VEHICLE_SPEED / distance;
-                vui->x += dx * ratio;
-                vui->y += dy * ratio;
-            }
-            
-            // Update the rectangle position
-            vui->rect.x = (int)vui->x - VEHICLE_WIDTH / 2;
-            vui->rect.y = (int)vui->y - VEHICLE_HEIGHT / 2;
-        }
-        
-        // Clean up vehicles that have reached their destination
-        int newCount = 0;
-        for (int i = 0; i < vehicleCount; i++) {
-            if (!activeVehicles[i].hasArrived) {
-                if (i != newCount) {
-                    activeVehicles[newCount] = activeVehicles[i];
-                }
-                newCount++;
+
+// Draws only the grid cells on screen. Zoomed far out, or with more
+// vehicles on screen than are worth drawing one by one, each cell becomes a
+// block shaded by how many vehicles it holds.
+ void renderVehicles(FrameBatch* frame, const Camera* camera, const SimSnapshot* snapshot, float alpha) {
+            SDL_Color borderColor = {0, 0, 0, 255};
+            SDL_Color textColor = {0, 0, 0, 255};
+            SDL_Color trackColor = {255, 140, 0, 255};
+
+            // Cells on screen, one extra all round for vehicles whose
+            // body pokes out of their cell
+            float minX, minY, maxX, maxY;
+            cameraVisibleWorld(camera, &minX, &minY, &maxX, &maxY);
+            int firstColumn = snapshotCell(minX) - 1, lastColumn = snapshotCell(maxX) + 1;
+            int firstRow = snapshotCell(minY) - 1, lastRow = snapshotCell(maxY) + 1;
+            if (firstColumn < 0) firstColumn = 0;
+            if (firstRow < 0) firstRow = 0;
+            if (lastColumn >= SNAPSHOT_GRID) lastColumn = SNAPSHOT_GRID - 1;
+            if (lastRow >= SNAPSHOT_GRID) lastRow = SNAPSHOT_GRID - 1;
+
+            int visible = 0;
+            for (int row = firstRow; row <= lastRow; row++) {
+                visible += snapshot->cellStart[row * SNAPSHOT_GRID + lastColumn + 1] -
+                           snapshot->cellStart[row * SNAPSHOT_GRID + firstColumn];
             }
-        }
-        vehicleCount = newCount;
-    }
- void renderVehicles(SDL_Renderer* renderer, TTF_Font* font) {
-            printf("Rendering %d vehicles\n", vehicleCount);
-            
-            for (int i = 0; i < vehicleCount; i++) {
-                VehicleUI* vui = &activeVehicles[i];
-                
-                // Debug print
-                printf("Vehicle %s at (%f, %f), rect: (%d, %d, %d, %d)\n", 
-                       vui->vehicle.VechicleName, vui->x, vui->y, 
-                       vui->rect.x, vui->rect.y, vui->rect.w, vui->rect.h);
-                
-                // Get color based on vehicle name
-                SDL_Color color = getVehicleColor(vui->vehicle.VechicleName);
-                SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-                
-                // Draw the vehicle rectangle
-                SDL_RenderFillRect(renderer, &vui->rect);
-                
-                // Add a border
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                SDL_RenderDrawRect(renderer, &vui->rect);
-                
-                // Display vehicle name
-                SDL_Color textColor = {0, 0, 0, 255};
-                SDL_Surface* textSurface = TTF_RenderText_Solid(font, vui->vehicle.VechicleName, textColor);
-                if (textSurface) {
-                    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, textSurface);
-                    if (texture) {
-                        SDL_Rect textRect = {
-                            vui->rect.x, 
-                            vui->rect.y - 20, 
-                            textSurface->w, 
-                            textSurface->h
-                        };
-                        SDL_RenderCopy(renderer, texture, NULL, &textRect);
-                        SDL_DestroyTexture(texture);
+
+            if (camera->zoom < DENSITY_MIN_ZOOM || visible > DENSITY_MAX_VEHICLES) {
+                for (int row = firstRow; row <= lastRow; row++) {
+                    for (int column = firstColumn; column <= lastColumn; column++) {
+                        int cell = row * SNAPSHOT_GRID + column;
+                        int count = snapshot->cellStart[cell + 1] - snapshot->cellStart[cell];
+                        if (count == 0) continue;
+                        cameraFillRect(&frame->shapes, camera, column * SNAPSHOT_CELL_SIZE, row * SNAPSHOT_CELL_SIZE,
+                                       SNAPSHOT_CELL_SIZE, SNAPSHOT_CELL_SIZE, densityColor(count));
                     }
-                    SDL_FreeSurface(textSurface);
                 }
-            }
-        }
-
-// Add a new vehicle to the UI
-void addVehicleToUI(Vehicle vehicle, Road* roads[MAX_ROADS]) {
-    if (vehicleCount >= 100) return; // Avoid overflow
-    
-    VehicleUI* vui = &activeVehicles[vehicleCount++];
-    vui->vehicle = vehicle;
-    
-    // Set initial position based on the source lane
-    int startX, startY, endX, endY;
-    getLaneCoordinates(vehicle.currentLane, &startX, &startY, &endX, &endY, roads);
-    
-    // DEBUG: Print lane coordinates
-    printf("Lane coords: Start(%d,%d), End(%d,%d)\n", startX, startY, endX, endY);
-    
-    vui->x = startX;
-    vui->y = startY;
-    vui->rect.x = (int)vui->x - VEHICLE_WIDTH / 2; // Center the vehicle on the lane
-    vui->rect.y = (int)vui->y - VEHICLE_HEIGHT / 2;
-    vui->rect.w = VEHICLE_WIDTH;
-    vui->rect.h = VEHICLE_HEIGHT;
-    vui->isMoving = true;
-    vui->hasArrived = false;
-    vui->pathStep = 0;
-    
-    // Calculate the full path through the intersection
-    int pathX[4], pathY[4], numPoints;
-    calculatePath(vehicle.currentLane, vehicle.destinationLane, pathX, pathY, &numPoints, roads);
-    
-    // Print path information for debugging
-    printf("Vehicle %s path: (%d,%d) -> (%d,%d) -> (%d,%d) -> (%d,%d)\n", 
-           vehicle.VechicleName, pathX[0], pathY[0], pathX[1], pathY[1], 
-           pathX[2], pathY[2], pathX[3], pathY[3]);
-    
-    // Set initial target to the entry of the intersection
-    vui->targetX = pathX[0];
-    vui->targetY = pathY[0];
-    
-    printf("Vehicle %s added at (%f,%f) with rect at (%d,%d)\n", 
-           vehicle.VechicleName, vui->x, vui->y, vui->rect.x, vui->rect.y);
-}
-
-// Check if we need to dequeue vehicles from the lanes
-void processVehicleQueues(Road* roads[MAX_ROADS], bool trafficLightStatus[MAX_ROADS]) {
-    for (int i = 0; i < MAX_ROADS; i++) {
-        if (trafficLightStatus[i]) { // If green light
-            for (int j = 0; j < MAX_LANE_SIZE; j++) {
-                Lane* lane = &roads[i]->lanes[j];
-                
-                // Only try to dequeue if the lane has vehicles waiting
-                SDL_LockMutex(lane->queue.mutex);
-                int queueCount = lane->queue.count;
-                SDL_UnlockMutex(lane->queue.mutex);
-                
-                if (queueCount > 0) {
-                    // Check if not too many vehicles are already in the intersection
-                    if (vehicleCount < 10) {
-                        SDL_LockMutex(lane->queue.mutex);
-                        if (lane->queue.count > 0) {
-                            Vehicle vehicle = dequeue(&lane->queue);
-                            vehicle.currentLane = lane;
-                            printf("Dequeued vehicle %s from %s\n", 
-                                   vehicle.VechicleName, lane->laneName);
-                            addVehicleToUI(vehicle, roads);
+            } else {
+                bool labels = camera->zoom >= LABEL_MIN_ZOOM;
+                for (int row = firstRow; row <= lastRow; row++) {
+                    // Cells in a row are contiguous, so a row is one run
+                    int first = snapshot->cellStart[row * SNAPSHOT_GRID + firstColumn];
+                    int last = snapshot->cellStart[row * SNAPSHOT_GRID + lastColumn + 1];
+                    for (int i = first; i < last; i++) {
+                        const JunctionVehicle* vs = &snapshot->vehicles[i];
+                        
+                        // Interpolate between the last two simulated positions
+                        float x = vs->prevX + (vs->x - vs->prevX) * alpha;
+                        float y = vs->prevY + (vs->y - vs->prevY) * alpha;
+                        float left = (int)x - VEHICLE_WIDTH / 2;
+                        float top = (int)y - VEHICLE_HEIGHT / 2;
+                        
+                        // Body coloured by vehicle name, then a border on top
+                        cameraFillRect(&frame->shapes, camera, left, top, VEHICLE_WIDTH, VEHICLE_HEIGHT,
+                                       getVehicleColor(vs->plate));
+                        cameraDrawRect(&frame->shapes, camera, left, top, VEHICLE_WIDTH, VEHICLE_HEIGHT, borderColor);
+                        
+                        // Vehicle name above it, only while it is readable
+                        if (labels) {
+                            float screenX, screenY;
+                            cameraToScreen(camera, left, top, &screenX, &screenY);
+                            batchText(&frame->text, &frame->atlas, vs->plate, screenX, screenY - 20, textColor);
                         }
-                        SDL_UnlockMutex(lane->queue.mutex);
                     }
                 }
             }
-        }
-    }
-}
-void updateTrafficLightStatus(bool trafficLightStatus[MAX_ROADS], SharedData* sharedData) {
-    for (int i = 0; i < MAX_ROADS; i++) {
-        trafficLightStatus[i] = (sharedData->currentLight == i);
-    }
-    printf("Traffic light status: [%d, %d, %d, %d]\n", 
-           trafficLightStatus[0], trafficLightStatus[1], 
-           trafficLightStatus[2], trafficLightStatus[3]);
-}
 
+            // Ring around the tracked vehicle at every level of detail
+            if (snapshot->tracked.state == JUNCTION_IN_FLIGHT) {
+                const JunctionVehicle* vs = &snapshot->tracked.vehicle;
+                float x = vs->prevX + (vs->x - vs->prevX) * alpha;
+                float y = vs->prevY + (vs->y - vs->prevY) * alpha;
+                float left = (int)x - VEHICLE_WIDTH / 2;
+                float top = (int)y - VEHICLE_HEIGHT / 2;
+                float pad = 4 / camera->zoom;
+                cameraDrawRect(&frame->shapes, camera, left - pad, top - pad,
+                               VEHICLE_WIDTH + 2 * pad, VEHICLE_HEIGHT + 2 * pad, trackColor);
+            }
+        }
 
-
-
-void* chequeQueue(void* arg){
-    SharedData* sharedData = (SharedData*)arg;
-    int i = 1;
-    while (1) {
-        sharedData->nextLight = 0;
-        sleep(5);
-        sharedData->nextLight = 2;
-        sleep(5);
-    }
-}
-
-void cleanup(ThreadData* data){
-    if(!data) return;
-    for (int i=0;i<4;i++){
-        free(data->roads[i]);
-    }
-    free(data->roads);
-    free(data);
-}
-
+// File thread: every 2 simulated seconds takes the whole backlog of the
+// vehicle file and hands it to the parallel parser
 void* readAndParseFile(void* arg) {
     ThreadData* data = (ThreadData*)arg;
-    Road** roads = data->roads;
+    unsigned int seeds[JUNCTION_ROADS];
+    initIngestSeeds(seeds);
 
     while (1) {
-        // Check if file exists and has content
-        FILE* file = fopen(VEHICLE_FILE, "r");
-        if (!file) {
+        double started = monotonicSeconds();
+        // Hand over to the simulation thread at the next tick
+        int count = ingestVehicleFile(data->junction, VEHICLE_FILE, options.ingestWorkers, seeds);
+        if (count < 0) {
             printf("Vehicle file not found, trying again in 2 seconds\n");
-            sleep(2);
-            continue;
+        } else if (count > 0) {
+            printf("Ingested %d vehicles in %.3f s\n", count, monotonicSeconds() - started);
         }
-
-        // Read first line only
-        char line[MAX_LINE_LENGTH];
-        int firstlineProcessed = 0;
-        long writePos = 0;
-        
-        while (fgets(line, sizeof(line), file)) {
-            if (!firstlineProcessed) {
-                printf("DEBUG: Processing line: %s\n", line);
-                firstlineProcessed = 1;
-                line[strcspn(line, "\n")] = 0; // Remove newline
-                
-                Road* roadPassed = NULL;
-                char* vehicleNumber = strtok(line, ":");
-                char* roadName = strtok(NULL, ":");
-
-                if (vehicleNumber && roadName) {
-                    // Assign roadPassed
-                    if (strcmp(roadName, "A") == 0) roadPassed = roads[0];
-                    else if (strcmp(roadName, "B") == 0) roadPassed = roads[1];
-                    else if (strcmp(roadName, "C") == 0) roadPassed = roads[2];
-                    else if (strcmp(roadName, "D") == 0) roadPassed = roads[3];
-
-                    if (roadPassed) {
-                        Vehicle vehicle;
-                        strncpy(vehicle.VechicleName, vehicleNumber, sizeof(vehicle.VechicleName));
-                        vehicle.road = roadPassed;
-                        
-                        // Select a random lane and set destination
-                        int laneIndex = rand() % MAX_LANE_SIZE;
-                        Lane* selectedLane = &(roadPassed->lanes[laneIndex]);
-                        vehicle.currentLane = selectedLane;
-                        
-                        // Generate destination lane
-                        Lane* destinationLane = generateDestination(selectedLane, roads);
-                        if (destinationLane) {
-                            vehicle.destinationLane = destinationLane;
-                            
-                            // Add directly to UI instead of queueing
-                            printf("Creating vehicle: %s, Road: %s, Lane: %d\n", 
-                                   vehicle.VechicleName, roadPassed->roadName, laneIndex);
-                            addVehicleToUI(vehicle, roads);
-                        } else {
-                            printf("Error: Could not generate destination for vehicle %s\n", 
-                                   vehicle.VechicleName);
-                        }
-                    }
-                }
-                writePos = ftell(file);
-            }
-        }
-     
-        // If we processed a line, remove it from the file
-        if (firstlineProcessed) {
-            // Overwrite file with remaining content
-            FILE* tempFile = fopen(VEHICLE_FILE, "r+"); // Reopen in read-write mode
-            if (tempFile) {
-                fseek(file, writePos, SEEK_SET); // Move to the remaining content
-                char buffer[MAX_LINE_LENGTH];
-
-                // Move remaining content to the start of the file
-                long newPos = 0;
-                while (fgets(buffer, sizeof(buffer), file)) {
-                    fseek(tempFile, newPos, SEEK_SET);
-                    fputs(buffer, tempFile);
-                    newPos = ftell(tempFile);
-                }
-
-                // Truncate file at new position
-                ftruncate(fileno(tempFile), newPos);
-                fclose(tempFile);
-            }
-        }
-
-        fclose(file);
-        sleep(2); // Sleep for 2 seconds before checking again
+        // Check again after 2 simulated seconds
+        if (!simClockSleep(&simClock, 2)) return NULL;
     }
     return NULL;
 }
\ No newline at end of file
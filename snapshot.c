@@ -0,0 +1,98 @@
+#include "snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void initTripleBuffer(TripleBuffer* buffer) {
+    memset(buffer->slots, 0, sizeof(buffer->slots));
+    buffer->unsorted = NULL;
+    buffer->unsortedCapacity = 0;
+    buffer->writeIndex = 0;
+    buffer->readIndex = 1;
+    atomic_init(&buffer->shared, 2);
+}
+
+void freeTripleBuffer(TripleBuffer* buffer) {
+    for (int i = 0; i < SNAPSHOT_SLOTS; i++) {
+        free(buffer->slots[i].vehicles);
+        buffer->slots[i].vehicles = NULL;
+        buffer->slots[i].capacity = 0;
+    }
+    free(buffer->unsorted);
+    buffer->unsorted = NULL;
+    buffer->unsortedCapacity = 0;
+}
+
+// Grows *vehicles to hold `count`; false if memory ran out
+static bool reserveVehicles(JunctionVehicle** vehicles, int* capacity, int count) {
+    if (count <= *capacity) return true;
+    int newCapacity = *capacity > 0 ? *capacity : 256;
+    while (newCapacity < count) newCapacity *= 2;
+    JunctionVehicle* grown = (JunctionVehicle*)realloc(*vehicles, sizeof(JunctionVehicle) * newCapacity);
+    if (grown == NULL) {
+        printf("Error: could not grow snapshot to %d vehicles\n", newCapacity);
+        return false;
+    }
+    *vehicles = grown;
+    *capacity = newCapacity;
+    return true;
+}
+
+// Returns the writer's slot, sized for vehicleCount vehicles. The caller
+// fills buffer->unsorted and then calls binSnapshotVehicles.
+// Returns NULL if the vehicle arrays could not be grown.
+SimSnapshot* beginSnapshotWrite(TripleBuffer* buffer, int vehicleCount) {
+    SimSnapshot* snapshot = &buffer->slots[buffer->writeIndex];
+    if (!reserveVehicles(&snapshot->vehicles, &snapshot->capacity, vehicleCount) ||
+        !reserveVehicles(&buffer->unsorted, &buffer->unsortedCapacity, vehicleCount)) {
+        return NULL;
+    }
+    snapshot->vehicleCount = vehicleCount;
+    return snapshot;
+}
+
+// Grid column or row of a world coordinate, clamped to the grid
+int snapshotCell(float coordinate) {
+    int cell = (int)(coordinate / SNAPSHOT_CELL_SIZE);
+    if (cell < 0) return 0;
+    if (cell >= SNAPSHOT_GRID) return SNAPSHOT_GRID - 1;
+    return cell;
+}
+
+// Counting sort of buffer->unsorted into the snapshot by grid cell: one
+// pass to count, one to place. Runs on the simulation thread, so the
+// renderer never pays for vehicles it does not draw.
+void binSnapshotVehicles(TripleBuffer* buffer, SimSnapshot* snapshot) {
+    int* start = snapshot->cellStart;
+    memset(start, 0, sizeof(snapshot->cellStart));
+    for (int i = 0; i < snapshot->vehicleCount; i++) {
+        const JunctionVehicle* vehicle = &buffer->unsorted[i];
+        start[snapshotCell(vehicle->y) * SNAPSHOT_GRID + snapshotCell(vehicle->x) + 1]++;
+    }
+    for (int c = 0; c < SNAPSHOT_GRID * SNAPSHOT_GRID; c++) start[c + 1] += start[c];
+
+    // start[c] is now where cell c begins; use it as a cursor and restore it after
+    for (int i = 0; i < snapshot->vehicleCount; i++) {
+        const JunctionVehicle* vehicle = &buffer->unsorted[i];
+        int cell = snapshotCell(vehicle->y) * SNAPSHOT_GRID + snapshotCell(vehicle->x);
+        snapshot->vehicles[start[cell]++] = *vehicle;
+    }
+    for (int c = SNAPSHOT_GRID * SNAPSHOT_GRID; c > 0; c--) start[c] = start[c - 1];
+    start[0] = 0;
+}
+
+// Hands the writer's slot to the reader and takes back the parked one
+void publishSnapshot(TripleBuffer* buffer) {
+    int previous = atomic_exchange(&buffer->shared, buffer->writeIndex | SNAPSHOT_FRESH);
+    buffer->writeIndex = previous & ~SNAPSHOT_FRESH;
+}
+
+// Returns the newest published snapshot, or the last one again if nothing
+// new has been published. The result stays valid until the next call.
+const SimSnapshot* acquireLatestSnapshot(TripleBuffer* buffer) {
+    if (atomic_load(&buffer->shared) & SNAPSHOT_FRESH) {
+        int previous = atomic_exchange(&buffer->shared, buffer->readIndex);
+        buffer->readIndex = previous & ~SNAPSHOT_FRESH;
+    }
+    return &buffer->slots[buffer->readIndex];
+}
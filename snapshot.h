@@ -0,0 +1,49 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "junction.h"
+
+#define SNAPSHOT_SLOTS 3
+#define SNAPSHOT_FRESH 4 // Set on the shared index when it holds an unread snapshot
+#define SNAPSHOT_GRID 32 // Cells per side of the grid vehicles are sorted into
+#define SNAPSHOT_CELL_SIZE ((float)JUNCTION_WORLD_SIZE / SNAPSHOT_GRID)
+
+// Immutable picture of the world after one simulation tick
+typedef struct {
+    unsigned long long tick;
+    double publishedAt;   // Monotonic time the snapshot was published, in seconds
+    double tickSeconds;   // Wall-clock length of the tick at the current speed, 0 => unlimited
+    int currentLight;
+    int laneCounts[JUNCTION_ROADS][JUNCTION_LANES_PER_ROAD];
+    JunctionVehicleLookup tracked; // Vehicle followed with --track
+    JunctionVehicle* vehicles;  // Sorted by grid cell, row by row
+    int vehicleCount;
+    int capacity;
+    // Vehicles in cell (column, row) are [cellStart[c], cellStart[c + 1]) with
+    // c = row * SNAPSHOT_GRID + column, so the renderer can read just the
+    // cells on screen
+    int cellStart[SNAPSHOT_GRID * SNAPSHOT_GRID + 1];
+} SimSnapshot;
+
+// Single-producer single-consumer triple buffer. The writer and reader each
+// own one slot; the third is parked in `shared` and swapped atomically, so
+// neither side ever waits for the other.
+typedef struct {
+    SimSnapshot slots[SNAPSHOT_SLOTS];
+    atomic_int shared;
+    int writeIndex;
+    int readIndex;
+    JunctionVehicle* unsorted;  // Writer's scratch: vehicles before they are binned
+    int unsortedCapacity;
+} TripleBuffer;
+
+void initTripleBuffer(TripleBuffer* buffer);
+void freeTripleBuffer(TripleBuffer* buffer);
+SimSnapshot* beginSnapshotWrite(TripleBuffer* buffer, int vehicleCount);
+void binSnapshotVehicles(TripleBuffer* buffer, SimSnapshot* snapshot);
+void publishSnapshot(TripleBuffer* buffer);
+int snapshotCell(float coordinate);
+const SimSnapshot* acquireLatestSnapshot(TripleBuffer* buffer);
+
+#endif
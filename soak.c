@@ -0,0 +1,183 @@
+#include "soak.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "simClock.h"
+
+#define SOAK_PLATE_DIGITS 7  // Base 36 digits after the "S"
+
+void initSoakConfig(SoakConfig* config) {
+    memset(config, 0, sizeof(*config));
+    config->ratePerMinute = 60;
+    config->durationSeconds = 3600;
+    config->reportSeconds = 60;
+    config->vehiclePath = "soak.data";
+    config->outputPath = "soak.csv";
+}
+
+static void soakPlate(unsigned long long sequence, char plate[SOAK_PLATE_DIGITS + 2]) {
+    static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    plate[0] = 'S';
+    for (int i = SOAK_PLATE_DIGITS; i >= 1; i--) {
+        plate[i] = digits[sequence % 36];
+        sequence /= 36;
+    }
+    plate[SOAK_PLATE_DIGITS + 1] = '\0';
+}
+
+// Sequence number of a soak plate, false for any other plate
+static bool soakSequence(const char* plate, unsigned long long* sequence) {
+    if (plate[0] != 'S') return false;
+    unsigned long long value = 0;
+    for (int i = 1; i <= SOAK_PLATE_DIGITS; i++) {
+        char c = plate[i];
+        if (c >= '0' && c <= '9') value = value * 36 + (unsigned long long)(c - '0');
+        else if (c >= 'A' && c <= 'Z') value = value * 36 + (unsigned long long)(c - 'A' + 10);
+        else return false;
+    }
+    *sequence = value;
+    return plate[SOAK_PLATE_DIGITS + 1] == '\0';
+}
+
+static void sleepUntil(double when) {
+    double wait = when - monotonicSeconds();
+    if (wait <= 0) return;
+    struct timespec duration = {(time_t)wait, (long)((wait - (time_t)wait) * 1e9)};
+    nanosleep(&duration, NULL);
+}
+
+// Writes one line per interval, on an absolute schedule so the rate does
+// not drift, flushing each like traffic_generator does
+static void* runSoakGenerator(void* arg) {
+    SoakMonitor* monitor = (SoakMonitor*)arg;
+    FILE* file = fopen(monitor->config->vehiclePath, "a");
+    if (!file) {
+        perror("Error opening soak vehicle file");
+        return NULL;
+    }
+    unsigned int seed = (unsigned int)time(NULL);
+    double interval = 60.0 / monitor->config->ratePerMinute;
+    double next = monitor->startedAt;
+    while (!atomic_load(&monitor->stopping)) {
+        unsigned long long sequence = atomic_load(&monitor->generated);
+        char plate[SOAK_PLATE_DIGITS + 2];
+        soakPlate(sequence, plate);
+        unsigned long long micros = (unsigned long long)((monotonicSeconds() - monitor->startedAt) * 1e6) + 1;
+        atomic_store_explicit(&monitor->writtenAt[sequence & (SOAK_RING - 1)], micros, memory_order_release);
+        fprintf(file, "%s:%c\n", plate, 'A' + rand_r(&seed) % 4);
+        fflush(file);
+        atomic_store(&monitor->generated, sequence + 1);
+        next += interval;
+        sleepUntil(next);
+    }
+    fclose(file);
+    return NULL;
+}
+
+bool startSoak(SoakMonitor* monitor, const SoakConfig* config, int ticksPerSecond) {
+    memset(monitor, 0, sizeof(*monitor));
+    monitor->config = config;
+    monitor->ticksPerSecond = ticksPerSecond;
+    monitor->writtenAt = (atomic_ullong*)calloc(SOAK_RING, sizeof(atomic_ullong));
+    if (!monitor->writtenAt) {
+        printf("Error: could not allocate soak test ring\n");
+        return false;
+    }
+    monitor->report = fopen(config->outputPath, "w");
+    if (!monitor->report) {
+        perror("Error opening soak report");
+        free(monitor->writtenAt);
+        return false;
+    }
+    fprintf(monitor->report, "elapsed_s,generated,observed,queued,in_flight,backlog_bytes,"
+            "ingest_lag_p50_ms,ingest_lag_p95_ms,ingest_lag_max_ms,"
+            "queue_delay_p50_s,queue_delay_p95_s,queue_delay_max_s,"
+            "end_to_end_p50_s,end_to_end_p95_s,end_to_end_max_s,rss_kb\n");
+    initWaitHistogram(&monitor->ingestLag);
+    initWaitHistogram(&monitor->queueDelay);
+    initWaitHistogram(&monitor->endToEnd);
+    monitor->startedAt = monotonicSeconds();
+    if (pthread_create(&monitor->generator, NULL, runSoakGenerator, monitor) != 0) {
+        printf("Error: could not start soak generator thread\n");
+        fclose(monitor->report);
+        free(monitor->writtenAt);
+        return false;
+    }
+    return true;
+}
+
+static unsigned long long milliseconds(double seconds) {
+    return seconds > 0 ? (unsigned long long)(seconds * 1000 + 0.5) : 0;
+}
+
+// Measures every soak vehicle in flight that has not been measured yet.
+// Wall-clock times of its arrival and release ticks are worked back from
+// when the snapshot was published and how long a tick lasts.
+void observeSoakSnapshot(SoakMonitor* monitor, const SimSnapshot* snapshot) {
+    for (int i = 0; i < snapshot->vehicleCount; i++) {
+        const JunctionVehicle* vehicle = &snapshot->vehicles[i];
+        unsigned long long sequence;
+        if (!soakSequence(vehicle->plate, &sequence)) continue;
+        unsigned long long micros = atomic_exchange(&monitor->writtenAt[sequence & (SOAK_RING - 1)], 0);
+        if (micros == 0) continue;  // Already measured
+
+        double written = monitor->startedAt + (micros - 1) / 1e6;
+        double arrived = snapshot->publishedAt - (snapshot->tick - vehicle->arrivalTick) * snapshot->tickSeconds;
+        double released = snapshot->publishedAt - (snapshot->tick - vehicle->releaseTick) * snapshot->tickSeconds;
+        waitHistogramRecord(&monitor->ingestLag, milliseconds(arrived - written));
+        waitHistogramRecord(&monitor->queueDelay,
+                            milliseconds((double)(vehicle->releaseTick - vehicle->arrivalTick) / monitor->ticksPerSecond));
+        waitHistogramRecord(&monitor->endToEnd, milliseconds(released - written));
+        monitor->observed++;
+    }
+}
+
+static long residentKilobytes(void) {
+    long pages = 0, resident = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    if (fscanf(file, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(file);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// One row for the interval just ended, then starts the next interval
+void writeSoakReport(SoakMonitor* monitor, const SimSnapshot* snapshot) {
+    struct stat info;
+    long long backlog = stat(monitor->config->vehiclePath, &info) == 0 ? (long long)info.st_size : 0;
+    int queued = 0;
+    for (int i = 0; i < JUNCTION_ROADS; i++) {
+        for (int j = 0; j < JUNCTION_LANES_PER_ROAD; j++) queued += snapshot->laneCounts[i][j];
+    }
+    double elapsed = monotonicSeconds() - monitor->startedAt;
+    long rss = residentKilobytes();
+    const WaitHistogram* lag = &monitor->ingestLag;
+    const WaitHistogram* delay = &monitor->queueDelay;
+    const WaitHistogram* total = &monitor->endToEnd;
+
+    fprintf(monitor->report, "%.0f,%llu,%llu,%d,%d,%lld,%.0f,%.0f,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%ld\n",
+            elapsed, atomic_load(&monitor->generated), monitor->observed, queued, snapshot->vehicleCount, backlog,
+            waitHistogramQuantile(lag, 0.5), waitHistogramQuantile(lag, 0.95), lag->max,
+            waitHistogramQuantile(delay, 0.5) / 1000, waitHistogramQuantile(delay, 0.95) / 1000, delay->max / 1000.0,
+            waitHistogramQuantile(total, 0.5) / 1000, waitHistogramQuantile(total, 0.95) / 1000, total->max / 1000.0,
+            rss);
+    fflush(monitor->report);
+    printf("Soak %.0f s: ingest lag p95 %.0f ms, queue delay p95 %.2f s, end to end p95 %.2f s, RSS %ld KB\n",
+           elapsed, waitHistogramQuantile(lag, 0.95), waitHistogramQuantile(delay, 0.95) / 1000,
+           waitHistogramQuantile(total, 0.95) / 1000, rss);
+
+    initWaitHistogram(&monitor->ingestLag);
+    initWaitHistogram(&monitor->queueDelay);
+    initWaitHistogram(&monitor->endToEnd);
+    monitor->observed = 0;
+}
+
+void stopSoak(SoakMonitor* monitor) {
+    atomic_store(&monitor->stopping, true);
+    pthread_join(monitor->generator, NULL);
+    fclose(monitor->report);
+    free(monitor->writtenAt);
+}
@@ -0,0 +1,50 @@
+#ifndef SOAK_H
+#define SOAK_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "snapshot.h"
+#include "waitHistogram.h"
+
+#define SOAK_RING_BITS 20                  // Generation times kept, by sequence number
+#define SOAK_RING (1 << SOAK_RING_BITS)
+#define SOAK_OBSERVE_MICROSECONDS 10000    // How often the latest snapshot is checked
+
+typedef struct {
+    double ratePerMinute;    // Vehicles written to the file per minute
+    double durationSeconds;  // Wall-clock length of the run
+    double reportSeconds;    // Wall-clock time between report rows
+    const char* vehiclePath; // File the generator writes and the reader ingests
+    const char* outputPath;  // CSV report
+} SoakConfig;
+
+// End-to-end soak test. A generator thread appends "PLATE:ROAD" lines at a
+// fixed rate, the simulator's own reader and simulation threads take them
+// through ingest and the lane queues, and the monitor watches the published
+// snapshots for them. Plates are "S" and the sequence number in base 36,
+// so a vehicle seen in flight leads back to the time its line was written.
+typedef struct {
+    const SoakConfig* config;
+    int ticksPerSecond;
+    double startedAt;                      // Monotonic seconds
+    atomic_ullong* writtenAt;              // Microseconds after startedAt, +1; 0 once measured
+    atomic_ullong generated;
+    atomic_bool stopping;
+    pthread_t generator;
+    FILE* report;
+
+    // This report interval; reset after each row
+    WaitHistogram ingestLag;   // Written to joined a lane queue, ms
+    WaitHistogram queueDelay;  // Joined the queue to released on green, ms of simulated time
+    WaitHistogram endToEnd;    // Written to released, ms
+    unsigned long long observed;
+} SoakMonitor;
+
+void initSoakConfig(SoakConfig* config);
+bool startSoak(SoakMonitor* monitor, const SoakConfig* config, int ticksPerSecond);
+void observeSoakSnapshot(SoakMonitor* monitor, const SimSnapshot* snapshot);
+void writeSoakReport(SoakMonitor* monitor, const SimSnapshot* snapshot);
+void stopSoak(SoakMonitor* monitor);
+
+#endif
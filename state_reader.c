@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sharedState.h"
+
+#define DEFAULT_INTERVAL_MS 1000
+
+// Prints the latest tick a simulator started with --shm NAME has
+// published: lights, every lane's queue and the vehicles crossing. Each
+// line comes from one consistent slot, read in place.
+// Usage: state_reader NAME [INTERVAL_MS [COUNT]]
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 4) {
+        printf("Usage: %s NAME [INTERVAL_MS [COUNT]]\n", argv[0]);
+        return 1;
+    }
+    int intervalMs = argc > 2 ? atoi(argv[2]) : DEFAULT_INTERVAL_MS;
+    long count = argc > 3 ? atol(argv[3]) : 0; // 0 => until interrupted
+
+    SharedStateReader reader;
+    if (!openSharedStateReader(&reader, argv[1])) return 1;
+    int capacity = reader.header->vehicleCapacity;
+
+    for (long printed = 0; count == 0 || printed < count; printed++) {
+        const SharedStateSlot* slot;
+        unsigned long long sequence, tick;
+        int greenRoad, inFlight, vehicles, queued[SHARED_STATE_ROADS][SHARED_STATE_LANES_PER_ROAD];
+        float sumX, sumY;
+        long retries = -1;
+        do {
+            if (++retries > 0) usleep(100); // Not published yet, or overwritten while read
+            slot = beginSharedStateRead(&reader, &sequence);
+            tick = slot->tick;
+            greenRoad = slot->greenRoad;
+            inFlight = slot->inFlight;
+            memcpy(queued, slot->laneCounts, sizeof(queued));
+            // The positions are summed in place rather than copied
+            vehicles = slot->vehicleCount < capacity ? slot->vehicleCount : capacity;
+            if (vehicles < 0) vehicles = 0;
+            sumX = 0;
+            sumY = 0;
+            for (int i = 0; i < vehicles; i++) {
+                sumX += slot->vehicles[i].x;
+                sumY += slot->vehicles[i].y;
+            }
+        } while (!endSharedStateRead(slot, sequence));
+
+        printf("tick %llu (%.1f s) green %c queues", tick, (double)tick / reader.header->ticksPerSecond,
+               'A' + greenRoad);
+        for (int i = 0; i < SHARED_STATE_ROADS; i++) {
+            printf(" %c:", 'A' + i);
+            for (int j = 0; j < SHARED_STATE_LANES_PER_ROAD; j++) printf("%s%d", j ? "/" : "", queued[i][j]);
+        }
+        printf(" in flight %d", inFlight);
+        if (vehicles > 0) printf(" centred at (%.0f, %.0f)", sumX / vehicles, sumY / vehicles);
+        printf(" retries %ld\n", retries);
+        fflush(stdout);
+        usleep(intervalMs * 1000);
+    }
+    closeSharedStateReader(&reader);
+    return 0;
+}
@@ -0,0 +1,294 @@
+#include "sweep.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define SWEEP_MAX_TRIALS (1 << 20)
+
+// Defaults: the current A/C plan, a handful of green times and rates
+void initSweepConfig(SweepConfig* config) {
+    memset(config, 0, sizeof(*config));
+    defaultSignalPlan(&config->plan);
+    double greens[] = {3, 5, 8, 12, 20};
+    double rates[] = {10, 20, 40};
+    config->greenCount = sizeof(greens) / sizeof(greens[0]);
+    memcpy(config->greenSeconds, greens, sizeof(greens));
+    config->rateCount = sizeof(rates) / sizeof(rates[0]);
+    memcpy(config->arrivalRates, rates, sizeof(rates));
+    config->seeds = 3;
+    config->durationSeconds = 3600;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN); // One trial per core
+    config->jobs = cores > 0 ? (int)cores : 1;
+    config->outputPath = "sweep.csv";
+}
+
+// Parses a comma separated list of positive numbers, e.g. "3,5,8"
+bool parseSweepValues(const char* text, double values[SWEEP_MAX_VALUES], int* count) {
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    *count = 0;
+
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* end;
+        double value = strtod(item, &end);
+        if (end == item || *end != '\0' || value <= 0) {
+            printf("Invalid sweep value: %s\n", item);
+            return false;
+        }
+        if (*count == SWEEP_MAX_VALUES) {
+            printf("At most %d sweep values are supported\n", SWEEP_MAX_VALUES);
+            return false;
+        }
+        values[(*count)++] = value;
+    }
+    return *count > 0;
+}
+
+static long long planCount(const SweepConfig* config) {
+    long long count = 1;
+    for (int i = 0; i < config->plan.phaseCount; i++) {
+        count *= config->greenCount;
+        if (count > SWEEP_MAX_TRIALS) return -1;
+    }
+    return count;
+}
+
+// The index-th combination of green times, phase 0 varying fastest
+static void planAt(const SweepConfig* config, long long index, SignalPlan* plan) {
+    *plan = config->plan;
+    for (int i = 0; i < plan->phaseCount; i++) {
+        plan->phaseSeconds[i] = config->greenSeconds[index % config->greenCount];
+        index /= config->greenCount;
+    }
+}
+
+static void trialAt(const SweepConfig* config, int trialIndex, SweepTrial* trial) {
+    int configIndex = trialIndex / config->seeds;
+    planAt(config, configIndex / config->rateCount, &trial->plan);
+    trial->arrivalRate = config->arrivalRates[configIndex % config->rateCount];
+    trial->seed = (unsigned int)(trialIndex % config->seeds) + 1;
+    trial->durationSeconds = config->durationSeconds;
+}
+
+// Child side: run the trial with output silenced and send the result up the pipe
+static void runChild(const SweepTrial* trial, SweepTrialRunner runner, int fd) {
+    SweepResult result;
+    memset(&result, 0, sizeof(result));
+    if (!freopen("/dev/null", "w", stdout)) {
+        _exit(1);
+    }
+    result.ok = runner(trial, &result);
+    // A result fits in the pipe buffer, so this never waits for the driver
+    const char* bytes = (const char*)&result;
+    size_t sent = 0;
+    while (sent < sizeof(result)) {
+        ssize_t written = write(fd, bytes + sent, sizeof(result) - sent);
+        if (written <= 0) _exit(1);
+        sent += written;
+    }
+    _exit(result.ok ? 0 : 1);
+}
+
+// Reads a whole result; the child has exited, so the pipe holds all of it
+static bool readResult(int fd, SweepResult* result) {
+    char* bytes = (char*)result;
+    size_t received = 0;
+    while (received < sizeof(*result)) {
+        ssize_t got = read(fd, bytes + received, sizeof(*result) - received);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        received += got;
+    }
+    return true;
+}
+
+// Seeds of one configuration pooled together
+typedef struct {
+    int runs;
+    unsigned long long arrived, dropped, released, departed;
+    double maxDelaySeconds;
+    int ticksPerSecond;
+    WaitHistogram waits;  // Every seed's waits merged, so quantiles cover all runs
+} SweepSummary;
+
+// Folds a finished trial into its configuration. Counts and histograms
+// add up exactly, so the report does not depend on the order trials end.
+static void addToSummary(SweepSummary* summary, const SweepResult* result) {
+    summary->runs++;
+    summary->arrived += result->arrived;
+    summary->dropped += result->dropped;
+    summary->released += result->released;
+    summary->departed += result->departed;
+    if (result->maxDelaySeconds > summary->maxDelaySeconds) {
+        summary->maxDelaySeconds = result->maxDelaySeconds;
+    }
+    summary->ticksPerSecond = result->ticksPerSecond;
+    waitHistogramMerge(&summary->waits, &result->waits);
+}
+
+typedef struct {
+    pid_t pid;
+    int fd;
+    int trial;
+} RunningTrial;
+
+// Runs every trial in its own process, at most `jobs` at a time.
+// Processes rather than threads: each instance has its own globals,
+// queues and RNG, so trials cannot interfere with each other.
+static bool runTrials(const SweepConfig* config, SweepTrialRunner runner,
+                      SweepSummary* summaries, int trialCount) {
+    RunningTrial* running = calloc(config->jobs, sizeof(RunningTrial));
+    if (!running) {
+        printf("Error: could not allocate sweep job table\n");
+        return false;
+    }
+    int next = 0, active = 0, finished = 0, failed = 0;
+
+    while (finished < trialCount) {
+        // Keep every job slot busy
+        while (active < config->jobs && next < trialCount) {
+            SweepTrial trial;
+            int fds[2];
+            trialAt(config, next, &trial);
+            if (pipe(fds) != 0) {
+                perror("Error creating sweep pipe");
+                break;
+            }
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid < 0) {
+                perror("Error starting sweep trial");
+                close(fds[0]);
+                close(fds[1]);
+                break;
+            }
+            if (pid == 0) {
+                close(fds[0]);
+                runChild(&trial, runner, fds[1]);
+            }
+            close(fds[1]);
+            for (int i = 0; i < config->jobs; i++) {
+                if (running[i].pid == 0) {
+                    running[i] = (RunningTrial){pid, fds[0], next};
+                    break;
+                }
+            }
+            active++;
+            next++;
+        }
+        if (active == 0) {
+            // Could not start anything; give up on the rest
+            printf("Error: sweep stopped after %d of %d trials\n", finished, trialCount);
+            break;
+        }
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            perror("Error waiting for sweep trial");
+            break;
+        }
+        for (int i = 0; i < config->jobs; i++) {
+            if (running[i].pid != pid) continue;
+            SweepResult result;
+            if (readResult(running[i].fd, &result) && result.ok &&
+                WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                addToSummary(&summaries[running[i].trial / config->seeds], &result);
+            } else {
+                failed++;
+            }
+            close(running[i].fd);
+            running[i].pid = 0;
+            active--;
+            finished++;
+            printf("Sweep: %d/%d trials done\r", finished, trialCount);
+            fflush(stdout);
+            break;
+        }
+    }
+    printf("\n");
+    if (failed > 0) printf("Warning: %d trials failed and are left out of the report\n", failed);
+    free(running);
+    return finished == trialCount;
+}
+
+static bool writeReport(const SweepConfig* config, const SweepSummary* summaries, int configCount) {
+    FILE* file = fopen(config->outputPath, "w");
+    if (!file) {
+        perror("Error opening sweep report");
+        return false;
+    }
+    const char* extension = strrchr(config->outputPath, '.');
+    bool json = extension && strcmp(extension, ".json") == 0;
+
+    if (json) fprintf(file, "[\n");
+    else fprintf(file, "plan,arrival_rate_per_min,runs,arrived,dropped,departed,"
+                       "throughput_per_hour,mean_delay_s,p50_delay_s,p95_delay_s,p99_delay_s,max_delay_s\n");
+
+    for (int c = 0; c < configCount; c++) {
+        const SweepSummary* summary = &summaries[c];
+        SignalPlan plan;
+        char planText[160];
+        planAt(config, c / config->rateCount, &plan);
+        formatSignalPlan(&plan, planText, sizeof(planText));
+        double rate = config->arrivalRates[c % config->rateCount];
+
+        // Per-run averages; delay is pooled over every released vehicle
+        double runs = summary->runs > 0 ? summary->runs : 1;
+        double throughput = summary->departed / runs / config->durationSeconds * 3600.0;
+        double tickSeconds = summary->ticksPerSecond > 0 ? 1.0 / summary->ticksPerSecond : 0;
+        double meanDelay = waitHistogramMean(&summary->waits) * tickSeconds;
+        double p50 = waitHistogramQuantile(&summary->waits, 0.50) * tickSeconds;
+        double p95 = waitHistogramQuantile(&summary->waits, 0.95) * tickSeconds;
+        double p99 = waitHistogramQuantile(&summary->waits, 0.99) * tickSeconds;
+
+        if (json) {
+            fprintf(file, "  {\"plan\": \"%s\", \"arrival_rate_per_min\": %g, \"runs\": %d, "
+                          "\"arrived\": %.1f, \"dropped\": %.1f, \"departed\": %.1f, "
+                          "\"throughput_per_hour\": %.2f, \"mean_delay_s\": %.3f, \"p50_delay_s\": %.3f, "
+                          "\"p95_delay_s\": %.3f, \"p99_delay_s\": %.3f, \"max_delay_s\": %.3f}%s\n",
+                    planText, rate, summary->runs, summary->arrived / runs, summary->dropped / runs,
+                    summary->departed / runs, throughput, meanDelay, p50, p95, p99, summary->maxDelaySeconds,
+                    c + 1 < configCount ? "," : "");
+        } else {
+            fprintf(file, "%s,%g,%d,%.1f,%.1f,%.1f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                    planText, rate, summary->runs, summary->arrived / runs, summary->dropped / runs,
+                    summary->departed / runs, throughput, meanDelay, p50, p95, p99, summary->maxDelaySeconds);
+        }
+    }
+    if (json) fprintf(file, "]\n");
+
+    bool ok = fclose(file) == 0;
+    if (!ok) perror("Error writing sweep report");
+    return ok;
+}
+
+// Runs the whole grid and writes the report. Must be called before the
+// process starts any threads, since every trial is a fork of it.
+int runSweep(const SweepConfig* config, SweepTrialRunner runner) {
+    long long plans = planCount(config);
+    if (plans < 0 || plans * config->rateCount * config->seeds > SWEEP_MAX_TRIALS) {
+        printf("Error: sweep grid has more than %d trials\n", SWEEP_MAX_TRIALS);
+        return -1;
+    }
+    int configCount = (int)plans * config->rateCount;
+    int trialCount = configCount * config->seeds;
+    printf("Sweep: %d timing plans x %d rates x %d seeds = %d trials, %d at a time\n",
+           (int)plans, config->rateCount, config->seeds, trialCount, config->jobs);
+
+    SweepSummary* summaries = calloc(configCount, sizeof(SweepSummary));
+    if (!summaries) {
+        printf("Error: could not allocate %d sweep summaries\n", configCount);
+        return -1;
+    }
+    bool complete = runTrials(config, runner, summaries, trialCount);
+    bool written = writeReport(config, summaries, configCount);
+    if (written) printf("Sweep report written to %s\n", config->outputPath);
+    free(summaries);
+    return complete && written ? 0 : -1;
+}
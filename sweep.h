@@ -0,0 +1,51 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+#include <stdbool.h>
+#include "signalPlan.h"
+#include "waitHistogram.h"
+
+#define SWEEP_MAX_VALUES 32
+
+// One headless run: a timing plan, an arrival rate and a seed
+typedef struct {
+    SignalPlan plan;
+    double arrivalRate;      // Vehicles per minute over the whole junction
+    unsigned int seed;
+    double durationSeconds;  // Simulated time
+} SweepTrial;
+
+// What a trial reports back to the driver
+typedef struct {
+    bool ok;
+    unsigned long long arrived;   // Joined a lane queue
+    unsigned long long dropped;   // Lane queue was full
+    unsigned long long released;  // Left a queue on green
+    unsigned long long departed;  // Reached the destination lane
+    double totalDelaySeconds;     // Queue wait summed over released vehicles
+    double maxDelaySeconds;
+    double wallSeconds;
+    int ticksPerSecond;           // Unit of `waits`
+    WaitHistogram waits;          // Queue wait of every released vehicle, in ticks
+} SweepResult;
+
+typedef bool (*SweepTrialRunner)(const SweepTrial* trial, SweepResult* result);
+
+// The grid. Every phase of `plan` is tried with every green time, so a
+// two phase plan with 8 green times gives 64 timing plans per rate.
+typedef struct {
+    SignalPlan plan;
+    double greenSeconds[SWEEP_MAX_VALUES];
+    int greenCount;
+    double arrivalRates[SWEEP_MAX_VALUES];
+    int rateCount;
+    int seeds;
+    double durationSeconds;
+    int jobs;                // Trials running at once, one process each
+    const char* outputPath;  // .json for JSON, anything else is CSV
+} SweepConfig;
+
+void initSweepConfig(SweepConfig* config);
+bool parseSweepValues(const char* text, double values[SWEEP_MAX_VALUES], int* count);
+int runSweep(const SweepConfig* config, SweepTrialRunner runner);
+
+#endif
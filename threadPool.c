@@ -0,0 +1,196 @@
+#include "threadPool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int defaultWorkerCount(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) cores = 1;
+    if (cores > THREAD_POOL_MAX_WORKERS) cores = THREAD_POOL_MAX_WORKERS;
+    return (int)cores;
+}
+
+static bool reserveDeque(WorkDeque* deque, int capacity) {
+    if (deque->capacity >= capacity) return true;
+    ChunkRange* grown = (ChunkRange*)realloc(deque->chunks, sizeof(ChunkRange) * capacity);
+    if (grown == NULL) {
+        printf("Error: could not grow work deque to %d chunks\n", capacity);
+        return false;
+    }
+    deque->chunks = grown;
+    deque->capacity = capacity;
+    return true;
+}
+
+// Owner side: take the most recently pushed chunk
+static bool popChunk(WorkDeque* deque, ChunkRange* chunk) {
+    bool found = false;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        *chunk = deque->chunks[--deque->tail];
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Thief side: take the oldest chunk so owner and thief work at opposite ends
+static bool stealChunk(WorkDeque* deque, ChunkRange* chunk) {
+    bool found = false;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        *chunk = deque->chunks[deque->head++];
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Drain our own deque, then steal from the others until nothing is left.
+// All chunks are queued before workers are woken, so an empty scan means done.
+static void runChunks(ThreadPool* pool, int index) {
+    ChunkRange chunk;
+    while (1) {
+        if (popChunk(&pool->deques[index], &chunk)) {
+            pool->task(pool->context, chunk.begin, chunk.end);
+            continue;
+        }
+        bool stolen = false;
+        for (int k = 1; k < pool->workerCount && !stolen; k++) {
+            int victim = (index + k) % pool->workerCount;
+            stolen = stealChunk(&pool->deques[victim], &chunk);
+        }
+        if (!stolen) return;
+        pool->task(pool->context, chunk.begin, chunk.end);
+    }
+}
+
+static void* workerMain(void* arg) {
+    WorkerArgs* args = (WorkerArgs*)arg;
+    ThreadPool* pool = args->pool;
+    int seenGeneration = 0;
+
+    while (1) {
+        pthread_mutex_lock(&pool->mutex);
+        while (pool->generation == seenGeneration && !pool->shuttingDown) {
+            pthread_cond_wait(&pool->workReady, &pool->mutex);
+        }
+        if (pool->shuttingDown) {
+            pthread_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+        seenGeneration = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        runChunks(pool, args->index);
+
+        pthread_mutex_lock(&pool->mutex);
+        pool->busyWorkers--;
+        if (pool->busyWorkers == 0) pthread_cond_signal(&pool->workDone);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+bool initThreadPool(ThreadPool* pool, int workerCount) {
+    if (workerCount < 1) workerCount = 1;
+    if (workerCount > THREAD_POOL_MAX_WORKERS) workerCount = THREAD_POOL_MAX_WORKERS;
+
+    pool->workerCount = workerCount;
+    pool->generation = 0;
+    pool->busyWorkers = 0;
+    pool->shuttingDown = false;
+    pool->task = NULL;
+    pool->context = NULL;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->workReady, NULL);
+    pthread_cond_init(&pool->workDone, NULL);
+
+    for (int i = 0; i < workerCount; i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        pool->deques[i].chunks = NULL;
+        pool->deques[i].head = 0;
+        pool->deques[i].tail = 0;
+        pool->deques[i].capacity = 0;
+        pool->args[i].pool = pool;
+        pool->args[i].index = i;
+    }
+
+    // Worker 0 is the thread calling threadPoolParallelFor
+    for (int i = 1; i < workerCount; i++) {
+        if (pthread_create(&pool->threads[i], NULL, workerMain, &pool->args[i]) != 0) {
+            printf("Error: could not start worker thread %d\n", i);
+            pool->workerCount = i;
+            break;
+        }
+    }
+    return true;
+}
+
+void destroyThreadPool(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->shuttingDown = true;
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 1; i < pool->workerCount; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (int i = 0; i < pool->workerCount; i++) {
+        free(pool->deques[i].chunks);
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    pthread_cond_destroy(&pool->workDone);
+    pthread_cond_destroy(&pool->workReady);
+    pthread_mutex_destroy(&pool->mutex);
+}
+
+// Runs task over [0, count) split into chunks and returns when all are done
+void threadPoolParallelFor(ThreadPool* pool, int count, int chunkSize, ChunkTask task, void* context) {
+    if (count <= 0) return;
+    if (chunkSize <= 0) chunkSize = THREAD_POOL_DEFAULT_CHUNK;
+
+    int chunkCount = (count + chunkSize - 1) / chunkSize;
+    if (pool->workerCount == 1 || chunkCount == 1) {
+        task(context, 0, count);
+        return;
+    }
+
+    // Deal chunks round-robin so every worker starts with local work
+    int perWorker = (chunkCount + pool->workerCount - 1) / pool->workerCount;
+    for (int i = 0; i < pool->workerCount; i++) {
+        WorkDeque* deque = &pool->deques[i];
+        pthread_mutex_lock(&deque->lock);
+        deque->head = 0;
+        deque->tail = 0;
+        if (!reserveDeque(deque, perWorker)) {
+            pthread_mutex_unlock(&deque->lock);
+            task(context, 0, count);
+            return;
+        }
+        pthread_mutex_unlock(&deque->lock);
+    }
+    for (int c = 0; c < chunkCount; c++) {
+        WorkDeque* deque = &pool->deques[c % pool->workerCount];
+        int begin = c * chunkSize;
+        int end = begin + chunkSize < count ? begin + chunkSize : count;
+        deque->chunks[deque->tail].begin = begin;
+        deque->chunks[deque->tail].end = end;
+        deque->tail++;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->task = task;
+    pool->context = context;
+    pool->busyWorkers = pool->workerCount - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->mutex);
+
+    runChunks(pool, 0);
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busyWorkers > 0) {
+        pthread_cond_wait(&pool->workDone, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,59 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <stdbool.h>
+#include <pthread.h>
+
+#define THREAD_POOL_MAX_WORKERS 64
+#define THREAD_POOL_DEFAULT_CHUNK 1024
+#define THREAD_POOL_CACHE_LINE 64
+
+// Work callback: process items [begin, end) of the current job
+typedef void (*ChunkTask)(void* context, int begin, int end);
+
+typedef struct {
+    int begin;
+    int end;
+} ChunkRange;
+
+// Per-worker deque. The owner pops from the tail, thieves take from the head.
+// Aligned so workers popping their own deques do not share a cache line.
+typedef struct {
+    _Alignas(THREAD_POOL_CACHE_LINE) pthread_mutex_t lock;
+    ChunkRange* chunks;
+    int head;
+    int tail;
+    int capacity;
+} WorkDeque;
+
+typedef struct ThreadPool ThreadPool;
+
+typedef struct {
+    ThreadPool* pool;
+    int index;
+} WorkerArgs;
+
+// Fixed set of workers that run parallel-for jobs. The calling thread takes
+// part as worker 0, so a pool of N workers creates N - 1 threads.
+struct ThreadPool {
+    pthread_t threads[THREAD_POOL_MAX_WORKERS];
+    WorkerArgs args[THREAD_POOL_MAX_WORKERS];
+    WorkDeque deques[THREAD_POOL_MAX_WORKERS];
+    int workerCount;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t workReady;
+    pthread_cond_t workDone;
+    int generation;
+    int busyWorkers;
+    bool shuttingDown;
+
+    ChunkTask task;
+    void* context;
+};
+
+int defaultWorkerCount(void);
+bool initThreadPool(ThreadPool* pool, int workerCount);
+void destroyThreadPool(ThreadPool* pool);
+void threadPoolParallelFor(ThreadPool* pool, int count, int chunkSize, ChunkTask task, void* context);
+
+#endif
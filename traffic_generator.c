@@ -1,9 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <time.h>
+#include <string.h>
 #include <unistd.h> // For sleep()
 
+#include "sharedState.h"
+
 #define FILENAME "vehicles.data"
+#define POLL_MICROSECONDS 1000 // How often the simulator's tick is checked with --shm
 
 // Function to generate a random vehicle number
 void generateVehicleNumber(char* buffer) {
@@ -23,7 +28,47 @@ char generateLane() {
     char roads[] = {'A', 'B', 'C', 'D'};
     return roads[rand() % 4];
 }
-int main() {
+// Simulated seconds the simulator has reached, false if no tick is
+// published yet or the slot changed while it was read
+bool readSimulatedSeconds(const SharedStateReader* reader, double* seconds) {
+    unsigned long long sequence;
+    const SharedStateSlot* slot = beginSharedStateRead(reader, &sequence);
+    unsigned long long tick = slot->tick;
+    if (!endSharedStateRead(slot, sequence)) return false;
+    *seconds = (double)tick / reader->header->ticksPerSecond;
+    return true;
+}
+
+void generateVehicle(FILE* file) {
+    char vehicle[9];
+    generateVehicleNumber(vehicle);
+    char road = generateLane();
+
+    // Write to file
+    fprintf(file, "%s:%c\n", vehicle, road);
+    fflush(file); // Ensure data is written immediately
+
+    printf("Generated: %s:%c\n", vehicle, road); // Print to console
+}
+
+// Usage: traffic_generator [--shm NAME]
+// With --shm the gaps between vehicles are simulated seconds, read from the
+// simulator started with the same --shm NAME, so time compression does not
+// change the traffic. Without it they are wall-clock seconds, which only
+// match a simulator running at --speed 1.
+int main(int argc, char* argv[]) {
+    const char* sharedName = NULL;
+    if (argc == 3 && strcmp(argv[1], "--shm") == 0) {
+        sharedName = argv[2];
+    } else if (argc != 1) {
+        printf("Usage: %s [--shm NAME]\n", argv[0]);
+        return 1;
+    }
+    SharedStateReader reader;
+    if (sharedName && !openSharedStateReader(&reader, sharedName)) {
+        return 1;
+    }
+
     FILE* file = fopen(FILENAME, "a");
     if (!file) {
         perror("Error opening file");
@@ -32,19 +77,26 @@ int main() {
 
     srand(time(NULL)); // Initialize random seed
 
-    while (1) {
-        char vehicle[9];
-        generateVehicleNumber(vehicle);
-        char road = generateLane();
-
-        // Write to file
-        fprintf(file, "%s:%c\n", vehicle, road);
-        fflush(file); // Ensure data is written immediately
-
-        printf("Generated: %s:%c\n", vehicle, road); // Print to console
+    if (!sharedName) {
+        while (1) {
+            generateVehicle(file);
+            int delay = 1000 + (rand() % 2000); // Delay between 1-3 seconds
+            usleep(delay * 1000); 
+        }
+    }
 
-        int delay = 1000 + (rand() % 2000); // Delay between 1-3 seconds
-        usleep(delay * 1000); 
+    // Every vehicle whose simulated time has come is written at once, so
+    // at high speeds several may go out between two polls
+    double now, next = -1;
+    while (1) {
+        if (readSimulatedSeconds(&reader, &now)) {
+            if (next < 0) next = now;
+            while (next <= now) {
+                generateVehicle(file);
+                next += (1000 + (rand() % 2000)) / 1000.0; // Delay between 1-3 simulated seconds
+            }
+        }
+        usleep(POLL_MICROSECONDS);
     }
 
     fclose(file);
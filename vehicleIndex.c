@@ -0,0 +1,116 @@
+#include "vehicleIndex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Plates share long common prefixes, so mix every bit into the bucket number
+static unsigned int bucketOf(PlateId id, int capacity) {
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+    return (unsigned int)id & (unsigned int)(capacity - 1);
+}
+
+bool initVehicleIndex(VehicleIndex* index, int initialCapacity) {
+    int capacity = 16;
+    while (capacity < initialCapacity) capacity *= 2;
+    index->entries = (VehicleIndexEntry*)calloc(capacity, sizeof(VehicleIndexEntry));
+    index->count = 0;
+    if (index->entries == NULL) {
+        printf("Memory allocation failed for vehicle index\n");
+        index->capacity = 0;
+        return false;
+    }
+    index->capacity = capacity;
+    return true;
+}
+
+void freeVehicleIndex(VehicleIndex* index) {
+    free(index->entries);
+    index->entries = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+void clearVehicleIndex(VehicleIndex* index) {
+    memset(index->entries, 0, sizeof(VehicleIndexEntry) * index->capacity);
+    index->count = 0;
+}
+
+static bool sameLocation(VehicleLocation a, VehicleLocation b) {
+    return a.where == b.where && a.road == b.road && a.lane == b.lane && a.slot == b.slot;
+}
+
+// Bucket holding id, or the empty bucket where it would go
+static int probe(const VehicleIndex* index, PlateId id) {
+    unsigned int mask = (unsigned int)index->capacity - 1;
+    unsigned int i = bucketOf(id, index->capacity);
+    while (index->entries[i].id != PLATE_ID_NONE && index->entries[i].id != id) {
+        i = (i + 1) & mask;
+    }
+    return (int)i;
+}
+
+// Doubles the table, keeping it at most 3/4 full
+static bool growVehicleIndex(VehicleIndex* index) {
+    VehicleIndex grown;
+    if (!initVehicleIndex(&grown, index->capacity * 2)) return false;
+    for (int i = 0; i < index->capacity; i++) {
+        const VehicleIndexEntry* entry = &index->entries[i];
+        if (entry->id != PLATE_ID_NONE) grown.entries[probe(&grown, entry->id)] = *entry;
+    }
+    grown.count = index->count;
+    freeVehicleIndex(index);
+    *index = grown;
+    return true;
+}
+
+// Adds a vehicle. Fails when the plate is already indexed: the first
+// vehicle with a plate keeps it until it leaves.
+bool vehicleIndexInsert(VehicleIndex* index, PlateId id, VehicleLocation location) {
+    if (id == PLATE_ID_NONE) return false;
+    if ((index->count + 1) * 4 > index->capacity * 3 && !growVehicleIndex(index)) return false;
+    int i = probe(index, id);
+    if (index->entries[i].id == id) return false;
+    index->entries[i].id = id;
+    index->entries[i].location = location;
+    index->count++;
+    return true;
+}
+
+// Removes entry i and shifts the rest of its probe cluster back so no
+// lookup stops early at the hole
+static void removeAt(VehicleIndex* index, int i) {
+    unsigned int mask = (unsigned int)index->capacity - 1;
+    unsigned int hole = (unsigned int)i;
+    unsigned int next = (hole + 1) & mask;
+    while (index->entries[next].id != PLATE_ID_NONE) {
+        unsigned int home = bucketOf(index->entries[next].id, index->capacity);
+        // Move the entry back unless its home lies cyclically in (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            index->entries[hole] = index->entries[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    index->entries[hole].id = PLATE_ID_NONE;
+    index->count--;
+}
+
+// Moves a vehicle from one location to another, or out of the index when
+// `to` is VEHICLE_NOWHERE. Only applies when the vehicle is indexed at
+// `from`, so a second vehicle with the same plate never moves the first.
+bool vehicleIndexMove(VehicleIndex* index, PlateId id, VehicleLocation from, VehicleLocation to) {
+    if (id == PLATE_ID_NONE) return false;
+    int i = probe(index, id);
+    if (index->entries[i].id != id || !sameLocation(index->entries[i].location, from)) return false;
+    if (to.where == VEHICLE_NOWHERE) removeAt(index, i);
+    else index->entries[i].location = to;
+    return true;
+}
+
+const VehicleLocation* vehicleIndexFind(const VehicleIndex* index, PlateId id) {
+    if (id == PLATE_ID_NONE) return NULL;
+    int i = probe(index, id);
+    return index->entries[i].id == id ? &index->entries[i].location : NULL;
+}
@@ -0,0 +1,43 @@
+#ifndef VEHICLEINDEX_H
+#define VEHICLEINDEX_H
+#include <stdbool.h>
+#include "plateId.h"
+
+#define VEHICLE_INDEX_INITIAL_CAPACITY 256 // Must be a power of two
+
+// Where a vehicle is
+#define VEHICLE_NOWHERE 0
+#define VEHICLE_QUEUED 1     // Waiting in a lane queue
+#define VEHICLE_IN_FLIGHT 2  // Crossing the junction
+
+// Handle to a vehicle: its lane and ring slot while queued, its index in
+// the active set while in flight
+typedef struct {
+    unsigned char where;
+    signed char road, lane;
+    int slot;
+} VehicleLocation;
+
+typedef struct {
+    PlateId id;  // PLATE_ID_NONE marks an empty bucket
+    VehicleLocation location;
+} VehicleIndexEntry;
+
+// Open-addressing hash table from plate ID to location. Linear probing
+// keeps a lookup to a couple of neighbouring buckets, and deletion shifts
+// the rest of the cluster back instead of leaving tombstones, so lookups
+// never slow down however many vehicles have passed through.
+typedef struct {
+    VehicleIndexEntry* entries;
+    int capacity;  // Power of two
+    int count;
+} VehicleIndex;
+
+bool initVehicleIndex(VehicleIndex* index, int initialCapacity);
+void freeVehicleIndex(VehicleIndex* index);
+void clearVehicleIndex(VehicleIndex* index);
+bool vehicleIndexInsert(VehicleIndex* index, PlateId id, VehicleLocation location);
+bool vehicleIndexMove(VehicleIndex* index, PlateId id, VehicleLocation from, VehicleLocation to);
+const VehicleLocation* vehicleIndexFind(const VehicleIndex* index, PlateId id);
+
+#endif
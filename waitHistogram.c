@@ -0,0 +1,61 @@
+#include "waitHistogram.h"
+#include <string.h>
+
+#define WAIT_HISTOGRAM_MAX_VALUE ((1ULL << WAIT_HISTOGRAM_MAX_BITS) - 1)
+
+void initWaitHistogram(WaitHistogram* histogram) {
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+// Values below 2 * SUB_BUCKETS get a bucket each; above that a value keeps
+// its top SUB_BITS + 1 bits and `shift` says how many were dropped
+static int bucketIndex(unsigned long long value) {
+    int top = 63 - __builtin_clzll(value | 1);
+    int shift = top > WAIT_HISTOGRAM_SUB_BITS ? top - WAIT_HISTOGRAM_SUB_BITS : 0;
+    return shift * WAIT_HISTOGRAM_SUB_BUCKETS + (int)(value >> shift);
+}
+
+// Middle of the range of values that land in `index`
+static double bucketMidpoint(int index) {
+    int shift = index < 2 * WAIT_HISTOGRAM_SUB_BUCKETS ? 0 : index / WAIT_HISTOGRAM_SUB_BUCKETS - 1;
+    unsigned long long low = (unsigned long long)(index - shift * WAIT_HISTOGRAM_SUB_BUCKETS) << shift;
+    return low + ((1ULL << shift) - 1) / 2.0;
+}
+
+void waitHistogramRecord(WaitHistogram* histogram, unsigned long long ticks) {
+    if (ticks > WAIT_HISTOGRAM_MAX_VALUE) ticks = WAIT_HISTOGRAM_MAX_VALUE;
+    histogram->counts[bucketIndex(ticks)]++;
+    histogram->count++;
+    histogram->sum += ticks;
+    if (ticks > histogram->max) histogram->max = ticks;
+}
+
+void waitHistogramMerge(WaitHistogram* into, const WaitHistogram* from) {
+    for (int i = 0; i < WAIT_HISTOGRAM_BUCKETS; i++) into->counts[i] += from->counts[i];
+    into->count += from->count;
+    into->sum += from->sum;
+    if (from->max > into->max) into->max = from->max;
+}
+
+// Smallest recorded value with at least `quantile` of the values at or
+// below it, e.g. 0.95 for p95. 0 when nothing was recorded.
+double waitHistogramQuantile(const WaitHistogram* histogram, double quantile) {
+    if (histogram->count == 0) return 0;
+    if (quantile >= 1.0) return (double)histogram->max;
+    unsigned long long rank = (unsigned long long)(quantile * histogram->count);
+    if (rank < quantile * histogram->count || rank < 1) rank++; // Round up
+
+    unsigned long long seen = 0;
+    for (int i = 0; i < WAIT_HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            double value = bucketMidpoint(i);
+            return value < histogram->max ? value : (double)histogram->max;
+        }
+    }
+    return (double)histogram->max;
+}
+
+double waitHistogramMean(const WaitHistogram* histogram) {
+    return histogram->count > 0 ? (double)histogram->sum / histogram->count : 0;
+}
@@ -0,0 +1,27 @@
+#ifndef WAITHISTOGRAM_H
+#define WAITHISTOGRAM_H
+
+// Log-linear (HDR style) histogram of waiting times in ticks. Each power of
+// two is split into WAIT_HISTOGRAM_SUB_BUCKETS equal buckets, so any value
+// is stored within about 3% whatever its size, in a fixed 7 KB however long
+// the run. Histograms add bucket by bucket, so lane histograms merge into
+// road and junction totals, and sweep seeds merge into one distribution.
+#define WAIT_HISTOGRAM_SUB_BITS 5
+#define WAIT_HISTOGRAM_SUB_BUCKETS (1 << WAIT_HISTOGRAM_SUB_BITS)
+#define WAIT_HISTOGRAM_MAX_BITS 32  // Longer waits are clamped, about 2 years at 60 ticks/s
+#define WAIT_HISTOGRAM_BUCKETS ((WAIT_HISTOGRAM_MAX_BITS - WAIT_HISTOGRAM_SUB_BITS + 1) * WAIT_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+    unsigned long long counts[WAIT_HISTOGRAM_BUCKETS];
+    unsigned long long count;
+    unsigned long long sum;  // Exact, for the mean
+    unsigned long long max;  // Exact
+} WaitHistogram;
+
+void initWaitHistogram(WaitHistogram* histogram);
+void waitHistogramRecord(WaitHistogram* histogram, unsigned long long ticks);
+void waitHistogramMerge(WaitHistogram* into, const WaitHistogram* from);
+double waitHistogramQuantile(const WaitHistogram* histogram, double quantile);
+double waitHistogramMean(const WaitHistogram* histogram);
+
+#endif